@@ -1,5 +1,7 @@
 #include "Actor.h"
 
+#include <algorithm>
+
 namespace sparkle
 {
 	Actor::Actor() {}
@@ -8,9 +10,9 @@ namespace sparkle
 
 	void Actor::Initialize(glm::vec3 position, glm::vec3 scale, glm::vec3 rotation)
 	{
-		transform->position = position;
-		transform->scale = scale;
-		transform->rotation = rotation;
+		transform->SetPosition(position);
+		transform->SetScale(scale);
+		transform->SetEulerAngles(rotation);
 	}
 
 	void Actor::Start()
@@ -25,6 +27,48 @@ namespace sparkle
 	{
 		component->actor = this;
 		components.push_back(component);
+		m_componentLookup.clear();
+
+		if (m_registry)
+		{
+			component->handle = m_registry->Add(component.get());
+		}
+	}
+
+	void Actor::RemoveComponent(Component* component)
+	{
+		auto it = std::find_if(components.begin(), components.end(), [component](const auto& c) { return c.get() == component; });
+		if (it == components.end())
+		{
+			return;
+		}
+
+		if (m_registry)
+		{
+			m_registry->Remove(component->handle);
+			component->handle = ComponentHandle();
+		}
+		component->actor = nullptr;
+		// Erasing may release the last reference to the component
+		components.erase(it);
+		m_componentLookup.clear();
+	}
+
+	void Actor::SetRegistry(ComponentRegistry* registry)
+	{
+		for (const auto& c : components)
+		{
+			if (m_registry)
+			{
+				m_registry->Remove(c->handle);
+				c->handle = ComponentHandle();
+			}
+			if (registry)
+			{
+				c->handle = registry->Add(c.get());
+			}
+		}
+		m_registry = registry;
 	}
 
 	void Actor::AddComponents(const std::initializer_list<std::shared_ptr<Component>>& newComponents)
@@ -43,19 +87,22 @@ namespace sparkle
 		}
 	}
 
-	void Actor::Update()
+	void Actor::Update(bool threadSafe)
 	{
 		for (const auto& c : components)
 		{
-			c->Update();
+			if (c->threadSafe == threadSafe)
+			{
+				c->Update();
+			}
 		}
 	}
 
-	void Actor::FixedUpdate()
+	void Actor::FixedUpdate(bool threadSafe)
 	{
 		for (const auto& c : components)
 		{
-			if (c->enabled)
+			if (c->enabled && c->threadSafe == threadSafe)
 			{
 				c->FixedUpdate();
 			}
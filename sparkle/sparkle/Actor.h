@@ -2,12 +2,15 @@
 
 #include <iostream>
 #include <vector>
+#include <typeindex>
+#include <unordered_map>
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <fmt/core.h>
 
 #include "Component.h"
+#include "ComponentRegistry.h"
 #include "Transform.h"
 
 namespace sparkle
@@ -25,9 +28,10 @@ namespace sparkle
 
 		void Start();
 
-		void Update();
+		// Updates the components whose threadSafe flag matches threadSafe
+		void Update(bool threadSafe);
 
-		void FixedUpdate();
+		void FixedUpdate(bool threadSafe);
 
 		void OnDestroy();
 
@@ -35,16 +39,31 @@ namespace sparkle
 
 		void AddComponents(const std::initializer_list<std::shared_ptr<Component>>& newComponents);
 
+		void RemoveComponent(Component* component);
+
+		/// <summary>
+		/// Registers all current and future components with registry (see GameInstance::AddActor).
+		/// </summary>
+		void SetRegistry(ComponentRegistry* registry);
+
+		// The first lookup of a type searches the components, later ones hit a cache until components change.
 		template <typename T>
 		std::enable_if_t<std::is_base_of<Component, T>::value, T*> GetComponent()
 		{
+			auto cached = m_componentLookup.find(std::type_index(typeid(T)));
+			if (cached != m_componentLookup.end())
+			{
+				return static_cast<T*>(cached->second);
+			}
+
 			T* result = nullptr;
 			for (auto c : components)
 			{
 				result = dynamic_cast<T*>(c.get());
 				if (result)
-					return result;
+					break;
 			}
+			m_componentLookup[std::type_index(typeid(T))] = result;
 			return result;
 		}
 
@@ -63,9 +82,14 @@ namespace sparkle
 			return result;
 		}
 
-		std::shared_ptr<Transform> transform = std::make_shared<Transform>(Transform(this));
+		std::shared_ptr<Transform> transform = std::make_shared<Transform>(this);
 		std::vector<std::shared_ptr<Component>> components;
 		std::string name;
+
+	private:
+		ComponentRegistry* m_registry = nullptr;
+		// Type of T -> GetComponent<T>() result (a T*, possibly null)
+		std::unordered_map<std::type_index, void*> m_componentLookup;
 	};
 
 }
\ No newline at end of file
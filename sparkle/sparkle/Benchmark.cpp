@@ -0,0 +1,348 @@
+#include "Benchmark.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+
+#include <glad/glad.h>
+#include <fmt/format.h>
+#include <glm.hpp>
+#include <gtc/quaternion.hpp>
+#include <gtc/constants.hpp>
+
+#include "Global.h"
+#include "GameInstance.h"
+#include "RenderPipeline.h"
+#include "SpEngine.h"
+#include "Camera.h"
+#include "Timer.h"
+#include "Resource.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <unistd.h>
+#include <sys/resource.h>
+#endif
+
+namespace sparkle
+{
+	namespace
+	{
+		// Resident memory of the process in MB
+		double CurrentMemoryMB()
+		{
+#ifdef _WIN32
+			PROCESS_MEMORY_COUNTERS counters;
+			GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+			return counters.WorkingSetSize / (1024.0 * 1024.0);
+#else
+			long pages = 0;
+			std::ifstream statm("/proc/self/statm");
+			statm >> pages >> pages;
+			return pages * (double)sysconf(_SC_PAGESIZE) / (1024.0 * 1024.0);
+#endif
+		}
+
+		double PeakMemoryMB()
+		{
+#ifdef _WIN32
+			PROCESS_MEMORY_COUNTERS counters;
+			GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+			return counters.PeakWorkingSetSize / (1024.0 * 1024.0);
+#else
+			rusage usage;
+			getrusage(RUSAGE_SELF, &usage);
+			return usage.ru_maxrss / 1024.0;
+#endif
+		}
+
+		double Percentile(std::vector<double> values, double fraction)
+		{
+			if (values.empty())
+			{
+				return 0.0;
+			}
+			const size_t index = std::min(values.size() - 1, (size_t)(fraction * values.size()));
+			std::nth_element(values.begin(), values.begin() + index, values.end());
+			return values[index];
+		}
+
+		// Value of "key": inside the "summary" object of a report written by Benchmark::Finish()
+		bool FindSummaryValue(const std::string& report, const std::string& key, double& value)
+		{
+			const size_t summary = report.find("\"summary\"");
+			if (summary == std::string::npos)
+			{
+				return false;
+			}
+			const size_t position = report.find("\"" + key + "\":", summary);
+			if (position == std::string::npos)
+			{
+				return false;
+			}
+			value = std::strtod(report.c_str() + position + key.size() + 3, nullptr);
+			return true;
+		}
+
+		// Metrics compared against the baseline; lower is better for all of them
+		const char* const k_comparedMetrics[] = { "cpuMsMedian", "gpuMsMedian", "solverMsMedian", "peakMemoryMB" };
+
+		// Metrics of a baseline below this are too small to compare relatively
+		const double k_minComparedValue = 0.01;
+	}
+
+	Benchmark::Benchmark(const BenchmarkOptions& options) : m_options(options)
+	{
+		m_frames.reserve(options.measuredFrames);
+	}
+
+	void Benchmark::Attach(GameInstance* game, const std::string& sceneName)
+	{
+		m_game = game;
+		m_sceneName = sceneName;
+
+		// Frames as fast as they render, so the timings show the work of a frame
+		Global::gameState.vsync = false;
+		Global::gameState.targetFrameRate = 0;
+		Global::gameState.pause = false;
+		Global::gameState.hideGUI = true;
+
+		if (Global::camera)
+		{
+			const glm::vec3 start = Global::camera->position();
+			m_hasCameraPath = true;
+			m_orbitRadius = glm::length(glm::vec2(start.x, start.z));
+			m_orbitHeight = start.y;
+			m_orbitStartAngle = std::atan2(start.x, start.z);
+		}
+		else
+		{
+			fmt::print("Warning(Benchmark): Scene has no camera; it stays where it is.\n");
+		}
+
+		game->godUpdate.Register([this]() { MoveCamera(); });
+		game->onBeginRender.Register([this]() { BeginRender(); });
+		game->renderPipeline()->onPassEnd.Register([this](const char* name) { EndPass(name); });
+		game->onEndFrame.Register([this]() { EndFrame(); });
+	}
+
+	void Benchmark::MoveCamera()
+	{
+		if (!m_hasCameraPath || Global::camera == nullptr)
+		{
+			return;
+		}
+
+		const float progress = measuring() ? (float)(m_frameIndex - m_options.warmupFrames) / m_options.measuredFrames : 0.0f;
+		const float angle = m_orbitStartAngle + glm::two_pi<float>() * progress;
+		const glm::vec3 position(m_orbitRadius * std::sin(angle), m_orbitHeight, m_orbitRadius * std::cos(angle));
+
+		auto transform = Global::camera->transform();
+		transform->SetPosition(position);
+		if (glm::length(position) > 0.0f)
+		{
+			transform->SetRotation(glm::quatLookAt(glm::normalize(-position), glm::vec3(0.0f, 1.0f, 0.0f)));
+		}
+	}
+
+	void Benchmark::BeginRender()
+	{
+		m_current = Frame();
+		m_passStart = Timer::CurrentTime();
+		if (measuring() && Global::engine->renders())
+		{
+			glGenQueries(1, &m_current.beginQuery);
+			glQueryCounter(m_current.beginQuery, GL_TIMESTAMP);
+		}
+	}
+
+	void Benchmark::EndPass(const char* name)
+	{
+		const double now = Timer::CurrentTime();
+		Pass pass;
+		pass.name = name;
+		pass.cpuMs = (now - m_passStart) * 1000.0;
+		if (m_current.beginQuery > 0)
+		{
+			glGenQueries(1, &pass.query);
+			glQueryCounter(pass.query, GL_TIMESTAMP);
+		}
+		m_current.renderCpuMs += pass.cpuMs;
+		m_current.passes.push_back(pass);
+		m_passStart = now;
+	}
+
+	void Benchmark::EndFrame()
+	{
+		if (!m_loaded)
+		{
+			// This frame may still have spent time on uploads, so counting starts with the next one
+			m_loaded = Resource::numPendingLoads() == 0;
+			if (m_loaded)
+			{
+				fmt::print("Info(Benchmark): Scene loaded after {} frames; starting warmup.\n", m_loadingFrames);
+			}
+			m_loadingFrames++;
+			m_current = Frame();
+			return;
+		}
+
+		if (measuring())
+		{
+			const auto& stats = Global::frameStats;
+			m_current.cpuMs = Timer::GetTimer("CPU_TIME") * 1000.0;
+			m_current.solverMs = Timer::GetTimerGPU("Solver_Total");
+			m_current.memoryMB = CurrentMemoryMB();
+			m_current.drawCalls = stats.drawCalls;
+			m_current.triangles = stats.triangles;
+			m_current.stateChanges = stats.stateChanges;
+			m_frames.push_back(std::move(m_current));
+		}
+		m_current = Frame();
+		m_frameIndex++;
+		if (m_frameIndex >= m_options.warmupFrames + m_options.measuredFrames)
+		{
+			m_game->Quit();
+		}
+	}
+
+	void Benchmark::ResolveQueries()
+	{
+		for (auto& frame : m_frames)
+		{
+			if (frame.beginQuery == 0)
+			{
+				continue;
+			}
+			GLuint64 previous;
+			glGetQueryObjectui64v(frame.beginQuery, GL_QUERY_RESULT, &previous);
+			glDeleteQueries(1, &frame.beginQuery);
+			for (auto& pass : frame.passes)
+			{
+				GLuint64 end;
+				glGetQueryObjectui64v(pass.query, GL_QUERY_RESULT, &end);
+				glDeleteQueries(1, &pass.query);
+				pass.gpuMs = (end - previous) / 1e6;
+				frame.gpuMs += pass.gpuMs;
+				previous = end;
+			}
+		}
+	}
+
+	std::vector<std::pair<std::string, double>> Benchmark::Summarize() const
+	{
+		std::vector<double> cpu, gpu, render, solver;
+		double drawCalls = 0.0;
+		double stateChanges = 0.0;
+		for (const auto& frame : m_frames)
+		{
+			cpu.push_back(frame.cpuMs);
+			gpu.push_back(frame.gpuMs);
+			render.push_back(frame.renderCpuMs);
+			solver.push_back(frame.solverMs);
+			drawCalls += frame.drawCalls;
+			stateChanges += frame.stateChanges;
+		}
+		const double numFrames = std::max<double>(1.0, (double)m_frames.size());
+
+		return {
+			{ "cpuMsMedian", Percentile(cpu, 0.5) },
+			{ "cpuMsP95", Percentile(cpu, 0.95) },
+			{ "renderCpuMsMedian", Percentile(render, 0.5) },
+			{ "gpuMsMedian", Percentile(gpu, 0.5) },
+			{ "gpuMsP95", Percentile(gpu, 0.95) },
+			{ "solverMsMedian", Percentile(solver, 0.5) },
+			{ "drawCallsMean", drawCalls / numFrames },
+			{ "stateChangesMean", stateChanges / numFrames },
+			{ "peakMemoryMB", PeakMemoryMB() },
+		};
+	}
+
+	int Benchmark::Finish()
+	{
+		if (m_frames.size() < m_options.measuredFrames)
+		{
+			fmt::print("Warning(Benchmark): Only {} of {} frames were measured.\n", m_frames.size(), m_options.measuredFrames);
+		}
+		ResolveQueries();
+		const auto summary = Summarize();
+
+		fmt::memory_buffer out;
+		fmt::format_to(std::back_inserter(out), "{{\n  \"scene\": \"{}\",\n  \"warmupFrames\": {},\n  \"measuredFrames\": {},\n  \"summary\": {{\n",
+			m_sceneName, m_options.warmupFrames, m_frames.size());
+		for (size_t i = 0; i < summary.size(); i++)
+		{
+			fmt::format_to(std::back_inserter(out), "    \"{}\": {:.4f}{}\n", summary[i].first, summary[i].second, i + 1 < summary.size() ? "," : "");
+		}
+		fmt::format_to(std::back_inserter(out), "  }},\n  \"frames\": [\n");
+		for (size_t i = 0; i < m_frames.size(); i++)
+		{
+			const auto& frame = m_frames[i];
+			fmt::format_to(std::back_inserter(out),
+				"    {{ \"cpuMs\": {:.4f}, \"renderCpuMs\": {:.4f}, \"gpuMs\": {:.4f}, \"solverMs\": {:.4f}, "
+				"\"drawCalls\": {}, \"triangles\": {}, \"stateChanges\": {}, \"memoryMB\": {:.2f}, \"passes\": {{",
+				frame.cpuMs, frame.renderCpuMs, frame.gpuMs, frame.solverMs, frame.drawCalls, frame.triangles, frame.stateChanges, frame.memoryMB);
+			for (size_t p = 0; p < frame.passes.size(); p++)
+			{
+				const auto& pass = frame.passes[p];
+				fmt::format_to(std::back_inserter(out), "{} \"{}\": {{ \"cpuMs\": {:.4f}, \"gpuMs\": {:.4f} }}",
+					p > 0 ? "," : "", pass.name, pass.cpuMs, pass.gpuMs);
+			}
+			fmt::format_to(std::back_inserter(out), " }} }}{}\n", i + 1 < m_frames.size() ? "," : "");
+		}
+		fmt::format_to(std::back_inserter(out), "  ]\n}}\n");
+
+		std::ofstream file(m_options.reportPath, std::ios::binary);
+		if (!file)
+		{
+			fmt::print("Error(Benchmark): Cannot write report to {}.\n", m_options.reportPath);
+			return -1;
+		}
+		file.write(out.data(), out.size());
+		fmt::print("Info(Benchmark): {} frames of {}: CPU {:.2f} ms, GPU {:.2f} ms (medians). Report written to {}.\n",
+			m_frames.size(), m_sceneName, summary[0].second, summary[3].second, m_options.reportPath);
+
+		return m_options.baselinePath.empty() ? 0 : CompareToBaseline(summary);
+	}
+
+	int Benchmark::CompareToBaseline(const std::vector<std::pair<std::string, double>>& summary) const
+	{
+		std::ifstream file(m_options.baselinePath, std::ios::binary);
+		if (!file)
+		{
+			fmt::print("Error(Benchmark): Cannot read baseline {}.\n", m_options.baselinePath);
+			return -1;
+		}
+		std::stringstream buffer;
+		buffer << file.rdbuf();
+		const std::string baseline = buffer.str();
+
+		bool regressed = false;
+		for (const char* metric : k_comparedMetrics)
+		{
+			double before;
+			if (!FindSummaryValue(baseline, metric, before) || before < k_minComparedValue)
+			{
+				continue;
+			}
+			const double after = std::find_if(summary.begin(), summary.end(), [metric](const auto& entry) { return entry.first == metric; })->second;
+			const double change = after / before - 1.0;
+			const bool isRegression = change > m_options.regressionThreshold;
+			regressed |= isRegression;
+			fmt::print("{}(Benchmark): {} {:.3f} -> {:.3f} ({:+.1f}%)\n", isRegression ? "Error" : "Info", metric, before, after, change * 100.0);
+		}
+
+		if (regressed)
+		{
+			fmt::print("Error(Benchmark): Regression beyond {:.0f}% against {}.\n", m_options.regressionThreshold * 100.0, m_options.baselinePath);
+			return 1;
+		}
+		return 0;
+	}
+}
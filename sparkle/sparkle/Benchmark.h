@@ -0,0 +1,106 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace sparkle
+{
+	class GameInstance;
+
+	struct BenchmarkOptions
+	{
+		bool enabled = false;
+		unsigned int warmupFrames = 60;
+		unsigned int measuredFrames = 600;
+		std::string reportPath = "benchmark.json";
+		// Report of an earlier run to compare against; empty for none
+		std::string baselinePath;
+		// Relative increase of a summary metric over the baseline that counts as a regression
+		double regressionThreshold = 0.1;
+	};
+
+	// Runs a scene for a fixed number of frames and reports per-frame timings and rendering statistics as JSON.
+	//
+	// Frames only start counting once all asynchronous loads of the scene are uploaded, so warmup and measurement
+	// see the complete scene however long loading takes. The first run on a machine cooks the scene's meshes and
+	// textures (see MeshCooker, TextureCooker) while loading, which makes it slow to start but doesn't change its
+	// measurements; later runs read the cooked files.
+	// The camera orbits the scene origin once over the measured frames, starting where the scene placed it,
+	// and the clock is simulated (see EngineOptions), so runs of the same build see the same frames.
+	// GPU times of the render passes come from OpenGL timestamp queries, which are only read back
+	// after the last frame, so measuring doesn't stall the pipeline.
+	class Benchmark
+	{
+	public:
+		Benchmark(const BenchmarkOptions& options);
+		Benchmark(const Benchmark&) = delete;
+
+		// Hooks into the callbacks of game; call once its scene is populated. Ends the game once all frames are measured.
+		void Attach(GameInstance* game, const std::string& sceneName);
+
+		/// <summary>
+		/// Reads back the GPU timings, so it must run while the OpenGL context is alive. Writes the report and compares its summary against the baseline, if any.
+		/// </summary>
+		/// <returns>0 on success, 1 if a metric regressed beyond the threshold, -1 on I/O errors</returns>
+		int Finish();
+
+	private:
+		struct Pass
+		{
+			std::string name;
+			double cpuMs = 0.0;
+			double gpuMs = 0.0;
+			// Timestamp query at the end of the pass
+			unsigned int query = 0;
+		};
+
+		struct Frame
+		{
+			double cpuMs = 0.0;
+			double renderCpuMs = 0.0;
+			// Sum of the passes' GPU times
+			double gpuMs = 0.0;
+			double solverMs = 0.0;
+			double memoryMB = 0.0;
+			unsigned int drawCalls = 0;
+			unsigned int triangles = 0;
+			unsigned int stateChanges = 0;
+
+			// Timestamp query before the first pass
+			unsigned int beginQuery = 0;
+			std::vector<Pass> passes;
+		};
+
+		bool measuring() const
+		{
+			return m_loaded && m_frameIndex >= m_options.warmupFrames;
+		}
+
+		void MoveCamera();
+		void BeginRender();
+		void EndPass(const char* name);
+		void EndFrame();
+
+		// Reads back the GPU timestamps of all measured frames
+		void ResolveQueries();
+		// Key-value pairs of the summary object, in report order
+		std::vector<std::pair<std::string, double>> Summarize() const;
+		int CompareToBaseline(const std::vector<std::pair<std::string, double>>& summary) const;
+
+		BenchmarkOptions m_options;
+		GameInstance* m_game = nullptr;
+		std::string m_sceneName;
+		// Whether the scene's asynchronous loads have all been uploaded; m_frameIndex stays at 0 until then
+		bool m_loaded = false;
+		unsigned int m_loadingFrames = 0;
+		unsigned int m_frameIndex = 0;
+		std::vector<Frame> m_frames;
+		Frame m_current;
+		double m_passStart = 0.0;
+
+		bool m_hasCameraPath = false;
+		float m_orbitRadius = 0.0f;
+		float m_orbitHeight = 0.0f;
+		float m_orbitStartAngle = 0.0f;
+	};
+}
@@ -0,0 +1,559 @@
+#include "Bvh.h"
+
+#include <numeric>
+#include <algorithm>
+
+#include "Global.h"
+#include "JobSystem.h"
+
+namespace sparkle
+{
+	namespace
+	{
+		const unsigned int k_numBins = 16;
+		// Cost of visiting a node relative to testing a triangle
+		const float k_traversalCost = 1.0f;
+		// Subtrees this deep become leaves whatever their size, which bounds the traversal stacks
+		const unsigned int k_maxDepth = 60;
+		const unsigned int k_stackSize = k_maxDepth + 4;
+
+		const unsigned int k_nodesPerRefitJob = 256;
+		const unsigned int k_queriesPerJob = 64;
+
+		// Distances along the ray at which it enters and leaves the box, with near > far for misses
+		glm::vec2 IntersectBox(const BvhNode& node, const glm::vec3& origin, const glm::vec3& inverseDirection, float maxDistance)
+		{
+			const glm::vec3 t0 = (node.min - origin) * inverseDirection;
+			const glm::vec3 t1 = (node.max - origin) * inverseDirection;
+			const glm::vec3 near = glm::min(t0, t1);
+			const glm::vec3 far = glm::max(t0, t1);
+			const float enter = std::max(std::max(near.x, near.y), std::max(near.z, 0.0f));
+			const float exit = std::min(std::min(far.x, far.y), std::min(far.z, maxDistance));
+			return glm::vec2(enter, exit);
+		}
+
+		float DistanceToBoxSquared(const BvhNode& node, const glm::vec3& point)
+		{
+			const glm::vec3 d = glm::max(glm::max(node.min - point, point - node.max), glm::vec3(0.0f));
+			return glm::dot(d, d);
+		}
+
+		// Möller-Trumbore, hitting both sides
+		bool IntersectTriangle(const glm::vec3& origin, const glm::vec3& direction, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c,
+			float& distance, glm::vec2& barycentric)
+		{
+			const glm::vec3 e1 = b - a;
+			const glm::vec3 e2 = c - a;
+			const glm::vec3 p = glm::cross(direction, e2);
+			const float determinant = glm::dot(e1, p);
+			if (std::abs(determinant) < 1e-12f)
+			{
+				return false;
+			}
+			const float inverseDeterminant = 1.0f / determinant;
+			const glm::vec3 s = origin - a;
+			const float u = glm::dot(s, p) * inverseDeterminant;
+			if (u < 0.0f || u > 1.0f)
+			{
+				return false;
+			}
+			const glm::vec3 q = glm::cross(s, e1);
+			const float v = glm::dot(direction, q) * inverseDeterminant;
+			if (v < 0.0f || u + v > 1.0f)
+			{
+				return false;
+			}
+			distance = glm::dot(e2, q) * inverseDeterminant;
+			barycentric = glm::vec2(u, v);
+			return distance >= 0.0f;
+		}
+
+		// Ericson, Real-Time Collision Detection, 5.1.5
+		glm::vec3 ClosestPointOnTriangle(const glm::vec3& p, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c)
+		{
+			const glm::vec3 ab = b - a;
+			const glm::vec3 ac = c - a;
+			const glm::vec3 ap = p - a;
+			const float d1 = glm::dot(ab, ap);
+			const float d2 = glm::dot(ac, ap);
+			if (d1 <= 0.0f && d2 <= 0.0f)
+			{
+				return a;
+			}
+
+			const glm::vec3 bp = p - b;
+			const float d3 = glm::dot(ab, bp);
+			const float d4 = glm::dot(ac, bp);
+			if (d3 >= 0.0f && d4 <= d3)
+			{
+				return b;
+			}
+
+			const float vc = d1 * d4 - d3 * d2;
+			if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+			{
+				return a + ab * (d1 / (d1 - d3));
+			}
+
+			const glm::vec3 cp = p - c;
+			const float d5 = glm::dot(ab, cp);
+			const float d6 = glm::dot(ac, cp);
+			if (d6 >= 0.0f && d5 <= d6)
+			{
+				return c;
+			}
+
+			const float vb = d5 * d2 - d1 * d6;
+			if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+			{
+				return a + ac * (d2 / (d2 - d6));
+			}
+
+			const float va = d3 * d6 - d5 * d4;
+			if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+			{
+				return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+			}
+
+			const float denominator = 1.0f / (va + vb + vc);
+			return a + ab * (vb * denominator) + ac * (vc * denominator);
+		}
+	}
+
+	void Bvh::Build(const glm::vec3* positions, unsigned int numVertices, const unsigned int* indices, unsigned int numIndices)
+	{
+		m_positions.assign(positions, positions + numVertices);
+
+		const unsigned int numTriangles = (indices ? numIndices : numVertices) / 3;
+		m_triangles.resize(numTriangles);
+		m_triangleIds.resize(numTriangles);
+		for (unsigned int i = 0; i < numTriangles; i++)
+		{
+			m_triangles[i] = indices ? glm::uvec3(indices[3 * i], indices[3 * i + 1], indices[3 * i + 2]) : glm::uvec3(3 * i, 3 * i + 1, 3 * i + 2);
+			m_triangleIds[i] = i;
+		}
+		BuildTree();
+	}
+
+	void Bvh::BuildTree()
+	{
+		m_nodes.clear();
+		m_levels.clear();
+		const unsigned int numTriangles = static_cast<unsigned int>(m_triangles.size());
+		if (numTriangles == 0)
+		{
+			m_cost = m_builtCost = 0.0f;
+			return;
+		}
+
+		std::vector<BvhBounds> triangleBounds(numTriangles);
+		std::vector<glm::vec3> centroids(numTriangles);
+		for (unsigned int i = 0; i < numTriangles; i++)
+		{
+			triangleBounds[i] = TriangleBounds(i);
+			centroids[i] = (triangleBounds[i].min + triangleBounds[i].max) * 0.5f;
+		}
+
+		std::vector<unsigned int> order(numTriangles);
+		std::iota(order.begin(), order.end(), 0u);
+		m_nodes.reserve(2 * numTriangles - 1);
+		BuildNode(triangleBounds, centroids, order, 0, numTriangles, 0);
+
+		// Leaves reference their triangles as contiguous ranges
+		std::vector<glm::uvec3> triangles(numTriangles);
+		std::vector<unsigned int> triangleIds(numTriangles);
+		for (unsigned int i = 0; i < numTriangles; i++)
+		{
+			triangles[i] = m_triangles[order[i]];
+			triangleIds[i] = m_triangleIds[order[i]];
+		}
+		m_triangles = std::move(triangles);
+		m_triangleIds = std::move(triangleIds);
+
+		m_cost = m_builtCost = ComputeCost();
+	}
+
+	unsigned int Bvh::BuildNode(const std::vector<BvhBounds>& triangleBounds, const std::vector<glm::vec3>& centroids,
+		std::vector<unsigned int>& order, unsigned int begin, unsigned int end, unsigned int depth)
+	{
+		const unsigned int index = static_cast<unsigned int>(m_nodes.size());
+		m_nodes.emplace_back();
+		if (m_levels.size() <= depth)
+		{
+			m_levels.resize(depth + 1);
+		}
+		m_levels[depth].push_back(index);
+
+		BvhBounds bounds, centroidBounds;
+		for (unsigned int i = begin; i < end; i++)
+		{
+			bounds.Grow(triangleBounds[order[i]]);
+			centroidBounds.Grow(centroids[order[i]]);
+		}
+		m_nodes[index].min = bounds.min;
+		m_nodes[index].max = bounds.max;
+
+		const unsigned int count = end - begin;
+		const auto makeLeaf = [this, index, begin, count]() {
+			m_nodes[index].offset = begin;
+			m_nodes[index].count = count;
+			return index;
+		};
+		if (count == 1 || depth >= k_maxDepth)
+		{
+			return makeLeaf();
+		}
+
+		// Binned SAH: for each axis, the cost of splitting between any two of k_numBins slabs of the centroid bounds
+		int bestAxis = -1;
+		unsigned int bestSplit = 0;
+		float bestCost = FLT_MAX;
+		for (int axis = 0; axis < 3; axis++)
+		{
+			const float extent = centroidBounds.max[axis] - centroidBounds.min[axis];
+			if (extent <= 0.0f)
+			{
+				continue;
+			}
+			const float scale = k_numBins / extent;
+
+			BvhBounds binBounds[k_numBins];
+			unsigned int binCounts[k_numBins] = {};
+			for (unsigned int i = begin; i < end; i++)
+			{
+				const unsigned int bin = std::min(k_numBins - 1, (unsigned int)((centroids[order[i]][axis] - centroidBounds.min[axis]) * scale));
+				binBounds[bin].Grow(triangleBounds[order[i]]);
+				binCounts[bin]++;
+			}
+
+			// rightCosts[i]: area times count of the bins after split i
+			float rightCosts[k_numBins - 1];
+			BvhBounds right;
+			unsigned int rightCount = 0;
+			for (unsigned int split = k_numBins - 1; split > 0; split--)
+			{
+				right.Grow(binBounds[split]);
+				rightCount += binCounts[split];
+				rightCosts[split - 1] = rightCount > 0 ? right.SurfaceArea() * rightCount : 0.0f;
+			}
+
+			BvhBounds left;
+			unsigned int leftCount = 0;
+			for (unsigned int split = 0; split < k_numBins - 1; split++)
+			{
+				left.Grow(binBounds[split]);
+				leftCount += binCounts[split];
+				const float cost = (leftCount > 0 ? left.SurfaceArea() * leftCount : 0.0f) + rightCosts[split];
+				if (leftCount > 0 && leftCount < count && cost < bestCost)
+				{
+					bestCost = cost;
+					bestAxis = axis;
+					bestSplit = split;
+				}
+			}
+		}
+
+		unsigned int middle;
+		if (bestAxis >= 0)
+		{
+			const float area = bounds.SurfaceArea();
+			const float splitCost = k_traversalCost + (area > 0.0f ? bestCost / area : (float)count);
+			if (splitCost >= count && count <= k_maxLeafTriangles)
+			{
+				return makeLeaf();
+			}
+			const float minimum = centroidBounds.min[bestAxis];
+			const float scale = k_numBins / (centroidBounds.max[bestAxis] - minimum);
+			const auto split = std::partition(order.begin() + begin, order.begin() + end, [&](unsigned int triangle) {
+				return std::min(k_numBins - 1, (unsigned int)((centroids[triangle][bestAxis] - minimum) * scale)) <= bestSplit;
+				});
+			middle = static_cast<unsigned int>(split - order.begin());
+		}
+		else if (count <= k_maxLeafTriangles)
+		{
+			return makeLeaf();
+		}
+		else
+		{
+			// All centroids coincide; any split is as good as another
+			middle = begin + count / 2;
+		}
+
+		BuildNode(triangleBounds, centroids, order, begin, middle, depth + 1);
+		const unsigned int second = BuildNode(triangleBounds, centroids, order, middle, end, depth + 1);
+		m_nodes[index].offset = second;
+		m_nodes[index].count = 0;
+		return index;
+	}
+
+	BvhBounds Bvh::TriangleBounds(unsigned int index) const
+	{
+		const glm::uvec3& triangle = m_triangles[index];
+		BvhBounds bounds;
+		bounds.Grow(m_positions[triangle.x]);
+		bounds.Grow(m_positions[triangle.y]);
+		bounds.Grow(m_positions[triangle.z]);
+		return bounds;
+	}
+
+	float Bvh::ComputeCost() const
+	{
+		float cost = 0.0f;
+		for (const auto& node : m_nodes)
+		{
+			BvhBounds bounds;
+			bounds.min = node.min;
+			bounds.max = node.max;
+			cost += bounds.SurfaceArea() * (node.leaf() ? (float)node.count : k_traversalCost);
+		}
+		const float rootArea = bounds().SurfaceArea();
+		return rootArea > 0.0f ? cost / rootArea : (float)m_triangles.size();
+	}
+
+	void Bvh::RefitNode(unsigned int index)
+	{
+		BvhNode& node = m_nodes[index];
+		BvhBounds bounds;
+		if (node.leaf())
+		{
+			for (unsigned int i = node.offset; i < node.offset + node.count; i++)
+			{
+				bounds.Grow(TriangleBounds(i));
+			}
+		}
+		else
+		{
+			const BvhNode& first = m_nodes[index + 1];
+			const BvhNode& second = m_nodes[node.offset];
+			bounds.min = glm::min(first.min, second.min);
+			bounds.max = glm::max(first.max, second.max);
+		}
+		node.min = bounds.min;
+		node.max = bounds.max;
+	}
+
+	void Bvh::Refit(const glm::vec3* positions)
+	{
+		std::copy(positions, positions + m_positions.size(), m_positions.begin());
+
+		// Deepest level first; every node only reads its children, which are one level further down
+		for (size_t level = m_levels.size(); level-- > 0;)
+		{
+			const auto& nodes = m_levels[level];
+			Global::jobs->ParallelFor(static_cast<unsigned int>(nodes.size()), [this, &nodes](unsigned int i) {
+				RefitNode(nodes[i]);
+				}, k_nodesPerRefitJob);
+		}
+		m_cost = ComputeCost();
+	}
+
+	bool Bvh::Update(const glm::vec3* positions)
+	{
+		Refit(positions);
+		if (m_cost > m_builtCost * k_rebuildCostRatio)
+		{
+			BuildTree();
+			return true;
+		}
+		return false;
+	}
+
+	BvhHit Bvh::Raycast(const BvhRay& ray) const
+	{
+		BvhHit result;
+		if (empty())
+		{
+			return result;
+		}
+		const glm::vec3 inverseDirection = 1.0f / ray.direction;
+		float closest = ray.maxDistance;
+
+		struct Entry
+		{
+			unsigned int node;
+			float distance;
+		};
+		Entry stack[k_stackSize];
+		unsigned int stackSize = 0;
+
+		const glm::vec2 rootSpan = IntersectBox(m_nodes[0], ray.origin, inverseDirection, closest);
+		if (rootSpan.x <= rootSpan.y)
+		{
+			stack[stackSize++] = { 0, rootSpan.x };
+		}
+
+		while (stackSize > 0)
+		{
+			const Entry entry = stack[--stackSize];
+			if (entry.distance > closest)
+			{
+				continue;
+			}
+
+			const BvhNode& node = m_nodes[entry.node];
+			if (node.leaf())
+			{
+				for (unsigned int i = node.offset; i < node.offset + node.count; i++)
+				{
+					const glm::uvec3& triangle = m_triangles[i];
+					float distance;
+					glm::vec2 barycentric;
+					if (IntersectTriangle(ray.origin, ray.direction, m_positions[triangle.x], m_positions[triangle.y], m_positions[triangle.z], distance, barycentric)
+						&& distance <= closest)
+					{
+						closest = distance;
+						result.triangle = m_triangleIds[i];
+						result.distance = distance;
+						result.barycentric = barycentric;
+					}
+				}
+				continue;
+			}
+
+			// Nearer child on top, so it is visited first and shortens the ray for the other
+			const unsigned int first = entry.node + 1;
+			const unsigned int second = node.offset;
+			const glm::vec2 firstSpan = IntersectBox(m_nodes[first], ray.origin, inverseDirection, closest);
+			const glm::vec2 secondSpan = IntersectBox(m_nodes[second], ray.origin, inverseDirection, closest);
+			const bool firstHit = firstSpan.x <= firstSpan.y;
+			const bool secondHit = secondSpan.x <= secondSpan.y;
+			if (firstHit && secondHit)
+			{
+				const bool firstNearer = firstSpan.x <= secondSpan.x;
+				stack[stackSize++] = firstNearer ? Entry{ second, secondSpan.x } : Entry{ first, firstSpan.x };
+				stack[stackSize++] = firstNearer ? Entry{ first, firstSpan.x } : Entry{ second, secondSpan.x };
+			}
+			else if (firstHit)
+			{
+				stack[stackSize++] = { first, firstSpan.x };
+			}
+			else if (secondHit)
+			{
+				stack[stackSize++] = { second, secondSpan.x };
+			}
+		}
+		return result;
+	}
+
+	void Bvh::Raycast(const BvhRay* rays, BvhHit* hits, unsigned int count) const
+	{
+		Global::jobs->ParallelFor(count, [this, rays, hits](unsigned int i) {
+			hits[i] = Raycast(rays[i]);
+			}, k_queriesPerJob);
+	}
+
+	BvhClosestPoint Bvh::ClosestPoint(const glm::vec3& point, float maxDistance) const
+	{
+		BvhClosestPoint result;
+		if (empty())
+		{
+			return result;
+		}
+		float closestSquared = maxDistance < FLT_MAX ? maxDistance * maxDistance : FLT_MAX;
+
+		struct Entry
+		{
+			unsigned int node;
+			float distanceSquared;
+		};
+		Entry stack[k_stackSize];
+		unsigned int stackSize = 0;
+		stack[stackSize++] = { 0, DistanceToBoxSquared(m_nodes[0], point) };
+
+		while (stackSize > 0)
+		{
+			const Entry entry = stack[--stackSize];
+			if (entry.distanceSquared > closestSquared)
+			{
+				continue;
+			}
+
+			const BvhNode& node = m_nodes[entry.node];
+			if (node.leaf())
+			{
+				for (unsigned int i = node.offset; i < node.offset + node.count; i++)
+				{
+					const glm::uvec3& triangle = m_triangles[i];
+					const glm::vec3 closest = ClosestPointOnTriangle(point, m_positions[triangle.x], m_positions[triangle.y], m_positions[triangle.z]);
+					const float distanceSquared = glm::dot(closest - point, closest - point);
+					if (distanceSquared <= closestSquared)
+					{
+						closestSquared = distanceSquared;
+						result.triangle = m_triangleIds[i];
+						result.point = closest;
+					}
+				}
+				continue;
+			}
+
+			const unsigned int first = entry.node + 1;
+			const unsigned int second = node.offset;
+			const float firstDistance = DistanceToBoxSquared(m_nodes[first], point);
+			const float secondDistance = DistanceToBoxSquared(m_nodes[second], point);
+			const bool firstNearer = firstDistance <= secondDistance;
+			stack[stackSize++] = firstNearer ? Entry{ second, secondDistance } : Entry{ first, firstDistance };
+			stack[stackSize++] = firstNearer ? Entry{ first, firstDistance } : Entry{ second, secondDistance };
+		}
+
+		if (result.found())
+		{
+			result.distance = std::sqrt(closestSquared);
+		}
+		return result;
+	}
+
+	void Bvh::ClosestPoint(const glm::vec3* points, BvhClosestPoint* results, unsigned int count, float maxDistance) const
+	{
+		Global::jobs->ParallelFor(count, [this, points, results, maxDistance](unsigned int i) {
+			results[i] = ClosestPoint(points[i], maxDistance);
+			}, k_queriesPerJob);
+	}
+
+	void Bvh::Overlap(const BvhBounds& bounds, std::vector<unsigned int>& triangles) const
+	{
+		if (empty())
+		{
+			return;
+		}
+
+		unsigned int stack[k_stackSize];
+		unsigned int stackSize = 0;
+		stack[stackSize++] = 0;
+
+		while (stackSize > 0)
+		{
+			const unsigned int index = stack[--stackSize];
+			const BvhNode& node = m_nodes[index];
+			BvhBounds nodeBounds;
+			nodeBounds.min = node.min;
+			nodeBounds.max = node.max;
+			if (!nodeBounds.Overlaps(bounds))
+			{
+				continue;
+			}
+
+			if (node.leaf())
+			{
+				for (unsigned int i = node.offset; i < node.offset + node.count; i++)
+				{
+					if (TriangleBounds(i).Overlaps(bounds))
+					{
+						triangles.push_back(m_triangleIds[i]);
+					}
+				}
+				continue;
+			}
+			stack[stackSize++] = node.offset;
+			stack[stackSize++] = index + 1;
+		}
+	}
+
+	void Bvh::Overlap(const BvhBounds* bounds, unsigned int count, std::vector<std::vector<unsigned int>>& triangles) const
+	{
+		triangles.resize(count);
+		Global::jobs->ParallelFor(count, [this, bounds, &triangles](unsigned int i) {
+			triangles[i].clear();
+			Overlap(bounds[i], triangles[i]);
+			}, k_queriesPerJob);
+	}
+}
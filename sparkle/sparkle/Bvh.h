@@ -0,0 +1,192 @@
+#pragma once
+
+#include <vector>
+#include <cfloat>
+
+#include <glm.hpp>
+
+namespace sparkle
+{
+	// Axis-aligned box; empty while min > max.
+	struct BvhBounds
+	{
+		glm::vec3 min = glm::vec3(FLT_MAX);
+		glm::vec3 max = glm::vec3(-FLT_MAX);
+
+		void Grow(const glm::vec3& point)
+		{
+			min = glm::min(min, point);
+			max = glm::max(max, point);
+		}
+
+		void Grow(const BvhBounds& other)
+		{
+			min = glm::min(min, other.min);
+			max = glm::max(max, other.max);
+		}
+
+		float SurfaceArea() const
+		{
+			const glm::vec3 extent = glm::max(max - min, glm::vec3(0.0f));
+			return 2.0f * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+		}
+
+		bool Overlaps(const BvhBounds& other) const
+		{
+			return glm::all(glm::lessThanEqual(min, other.max)) && glm::all(glm::lessThanEqual(other.min, max));
+		}
+	};
+
+	// 32 bytes, two to a cache line. Nodes are stored depth-first: an inner node's first child directly follows it.
+	struct BvhNode
+	{
+		glm::vec3 min;
+		// Leaves: first triangle in leaf order; inner nodes: index of the second child
+		unsigned int offset;
+		glm::vec3 max;
+		// Number of triangles of a leaf; 0 for inner nodes
+		unsigned int count;
+
+		bool leaf() const
+		{
+			return count > 0;
+		}
+	};
+
+	static_assert(sizeof(BvhNode) == 32, "BvhNode should fill half a cache line");
+
+	struct BvhRay
+	{
+		glm::vec3 origin = glm::vec3(0.0f);
+		// Need not be normalized; hit distances are in multiples of its length
+		glm::vec3 direction = glm::vec3(0.0f, 0.0f, -1.0f);
+		float maxDistance = FLT_MAX;
+	};
+
+	struct BvhHit
+	{
+		// Index of the triangle in the index buffer the tree was built from, i.e. first index / 3
+		unsigned int triangle = ~0u;
+		float distance = FLT_MAX;
+		// Weights of the triangle's second and third vertex at the hit point
+		glm::vec2 barycentric = glm::vec2(0.0f);
+
+		bool hit() const
+		{
+			return triangle != ~0u;
+		}
+	};
+
+	struct BvhClosestPoint
+	{
+		unsigned int triangle = ~0u;
+		glm::vec3 point = glm::vec3(0.0f);
+		float distance = FLT_MAX;
+
+		bool found() const
+		{
+			return triangle != ~0u;
+		}
+	};
+
+	// Bounding volume hierarchy over the triangles of a mesh, for ray casts, closest-point and overlap queries
+	// shared by picking, culling and collision.
+	//
+	// Built top-down with the surface area heuristic over binned triangle centroids. Deforming meshes keep
+	// their tree and refit its bounds bottom-up, one depth level at a time in parallel; Update() rebuilds once
+	// refitting has made the tree too costly to traverse compared to a fresh build.
+	// The batched queries split their inputs across the job system; all queries are safe to run concurrently.
+	class Bvh
+	{
+	public:
+		// Leaves hold at most this many triangles
+		static const unsigned int k_maxLeafTriangles = 8;
+		// Rebuild once the SAH cost of a refitted tree exceeds that of its build by this factor
+		static constexpr float k_rebuildCostRatio = 1.5f;
+
+		Bvh() = default;
+
+		/// <summary>
+		/// Builds the tree over a triangle list.
+		/// </summary>
+		/// <param name="indices">Three per triangle; if null, every three consecutive vertices form a triangle</param>
+		Bvh(const glm::vec3* positions, unsigned int numVertices, const unsigned int* indices, unsigned int numIndices)
+		{
+			Build(positions, numVertices, indices, numIndices);
+		}
+
+		void Build(const glm::vec3* positions, unsigned int numVertices, const unsigned int* indices, unsigned int numIndices);
+
+		/// <summary>
+		/// Moves the vertices to new positions, keeping the triangles and the tree topology, and recomputes all bounds.
+		/// </summary>
+		void Refit(const glm::vec3* positions);
+
+		/// <summary>
+		/// Refits to positions, then rebuilds if the refitted tree degraded beyond k_rebuildCostRatio.
+		/// </summary>
+		/// <returns>Whether the tree was rebuilt</returns>
+		bool Update(const glm::vec3* positions);
+
+		BvhHit Raycast(const BvhRay& ray) const;
+		void Raycast(const BvhRay* rays, BvhHit* hits, unsigned int count) const;
+
+		BvhClosestPoint ClosestPoint(const glm::vec3& point, float maxDistance = FLT_MAX) const;
+		void ClosestPoint(const glm::vec3* points, BvhClosestPoint* results, unsigned int count, float maxDistance = FLT_MAX) const;
+
+		/// <summary>
+		/// Appends the triangles whose bounds overlap bounds to triangles.
+		/// </summary>
+		void Overlap(const BvhBounds& bounds, std::vector<unsigned int>& triangles) const;
+		void Overlap(const BvhBounds* bounds, unsigned int count, std::vector<std::vector<unsigned int>>& triangles) const;
+
+		bool empty() const
+		{
+			return m_nodes.empty();
+		}
+
+		BvhBounds bounds() const
+		{
+			BvhBounds result;
+			if (!empty())
+			{
+				result.min = m_nodes[0].min;
+				result.max = m_nodes[0].max;
+			}
+			return result;
+		}
+
+		const std::vector<BvhNode>& nodes() const
+		{
+			return m_nodes;
+		}
+
+		// Expected cost of a query relative to testing one triangle, by the surface area heuristic
+		float cost() const
+		{
+			return m_cost;
+		}
+
+	private:
+		// Builds the tree over m_triangles and reorders them into leaf order
+		void BuildTree();
+		// Builds the subtree over order[begin, end) and returns its root
+		unsigned int BuildNode(const std::vector<BvhBounds>& triangleBounds, const std::vector<glm::vec3>& centroids,
+			std::vector<unsigned int>& order, unsigned int begin, unsigned int end, unsigned int depth);
+		void RefitNode(unsigned int index);
+		float ComputeCost() const;
+		BvhBounds TriangleBounds(unsigned int index) const;
+
+		std::vector<BvhNode> m_nodes;
+		// Vertex indices of the triangles, in leaf order
+		std::vector<glm::uvec3> m_triangles;
+		// Triangle index in the source index buffer for each triangle in leaf order
+		std::vector<unsigned int> m_triangleIds;
+		std::vector<glm::vec3> m_positions;
+		// Node indices by depth; nodes of one level don't depend on each other when refitting
+		std::vector<std::vector<unsigned int>> m_levels;
+
+		float m_cost = 0.0f;
+		float m_builtCost = 0.0f;
+	};
+}
@@ -65,6 +65,15 @@ struct SpSimParams
 	}
 };
 
+// Rendering work submitted during the current frame; reset by GameInstance at the start of each frame
+struct SpFrameStats
+{
+	unsigned int drawCalls = 0;
+	unsigned int triangles = 0;
+	// Programs, vertex arrays, textures, framebuffers and fixed-function toggles set by the renderer
+	unsigned int stateChanges = 0;
+};
+
 struct SpGameState
 {
 	bool step = false;
@@ -73,6 +82,8 @@ struct SpGameState
 	bool drawParticles = false;
 	bool hideGUI = false;
 	bool detailTimer = false;
+	bool vsync = false;
+	int targetFrameRate = 144; // 0 for no limit
 };
 
 template <class T, class... TArgs>
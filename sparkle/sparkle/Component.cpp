@@ -12,7 +12,7 @@ namespace sparkle
 		}
 		else
 		{
-			return std::make_shared<Transform>(Transform(nullptr));
+			return std::make_shared<Transform>(nullptr);
 		}
 	}
 }
\ No newline at end of file
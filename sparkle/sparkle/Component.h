@@ -2,6 +2,7 @@
 
 #include <iostream>
 #include <string>
+#include <cstdint>
 
 #include "Transform.h"
 
@@ -13,6 +14,13 @@ namespace sparkle
 {
 	class Actor;
 
+	// Stable reference to a component in a ComponentRegistry
+	struct ComponentHandle
+	{
+		uint32_t index = UINT32_MAX;
+		uint32_t generation = 0;
+	};
+
 	class Component
 	{
 	public:
@@ -32,6 +40,14 @@ namespace sparkle
 		std::shared_ptr<Transform> transform();
 
 		bool enabled = true;
+
+		// Set by components whose Update() and FixedUpdate() only touch their own actor (and no OpenGL),
+		// so they can run on worker threads in parallel with those of other actors. Components without
+		// updates set it too, so the serial pass on the main thread only visits the components that need it.
+		bool threadSafe = false;
+
+		// Set while the component's actor belongs to a GameInstance
+		ComponentHandle handle;
 	};
 
 }
\ No newline at end of file
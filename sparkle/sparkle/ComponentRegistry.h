@@ -0,0 +1,149 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <typeindex>
+#include <unordered_map>
+
+#include "Component.h"
+
+namespace sparkle
+{
+	// Index of every component added to the actors of a GameInstance.
+	// Components stay owned by their actors; the registry hands out stable handles to them,
+	// and keeps a dense array per queried type (including subclasses) that is only updated when
+	// components are added or removed, so per-frame queries don't touch unrelated components.
+	class ComponentRegistry
+	{
+	public:
+		ComponentRegistry() = default;
+		ComponentRegistry(const ComponentRegistry&) = delete;
+
+		ComponentHandle Add(Component* component)
+		{
+			uint32_t index;
+			if (!m_freeSlots.empty())
+			{
+				index = m_freeSlots.back();
+				m_freeSlots.pop_back();
+			}
+			else
+			{
+				index = static_cast<uint32_t>(m_slots.size());
+				m_slots.emplace_back();
+			}
+			m_slots[index].component = component;
+
+			for (auto& [type, view] : m_views)
+			{
+				view->Add(component);
+			}
+			return ComponentHandle{ index, m_slots[index].generation };
+		}
+
+		void Remove(ComponentHandle handle)
+		{
+			Component* component = Get(handle);
+			if (component == nullptr)
+			{
+				return;
+			}
+
+			for (auto& [type, view] : m_views)
+			{
+				view->Remove(component);
+			}
+			m_slots[handle.index].component = nullptr;
+			m_slots[handle.index].generation++;
+			m_freeSlots.push_back(handle.index);
+		}
+
+		// Returns nullptr if the component of the handle was removed.
+		Component* Get(ComponentHandle handle) const
+		{
+			if (handle.index >= m_slots.size() || m_slots[handle.index].generation != handle.generation)
+			{
+				return nullptr;
+			}
+			return m_slots[handle.index].component;
+		}
+
+		/// <summary>
+		/// All registered components of type T or derived from it.
+		/// The first query of a type scans all components once; afterwards it is a lookup.
+		/// The returned array is updated in place by Add() and Remove(); their order is unspecified.
+		/// </summary>
+		template <typename T>
+		const std::vector<T*>& View()
+		{
+			auto& view = m_views[std::type_index(typeid(T))];
+			if (view == nullptr)
+			{
+				auto typedView = std::make_unique<TypedView<T>>();
+				for (const auto& slot : m_slots)
+				{
+					if (slot.component)
+					{
+						typedView->Add(slot.component);
+					}
+				}
+				view = std::move(typedView);
+			}
+			return static_cast<TypedView<T>*>(view.get())->items;
+		}
+
+	private:
+		struct Slot
+		{
+			Component* component = nullptr;
+			uint32_t generation = 0;
+		};
+
+		struct ViewBase
+		{
+			virtual ~ViewBase() = default;
+			virtual void Add(Component* component) = 0;
+			virtual void Remove(Component* component) = 0;
+		};
+
+		template <typename T>
+		struct TypedView : ViewBase
+		{
+			std::vector<T*> items;
+			std::unordered_map<Component*, size_t> positions;
+
+			void Add(Component* component) override
+			{
+				if (T* item = dynamic_cast<T*>(component))
+				{
+					positions[component] = items.size();
+					items.push_back(item);
+				}
+			}
+
+			void Remove(Component* component) override
+			{
+				auto it = positions.find(component);
+				if (it == positions.end())
+				{
+					return;
+				}
+
+				// Swap with the last item to keep the array dense
+				const size_t position = it->second;
+				positions.erase(it);
+				T* last = items.back();
+				items.pop_back();
+				if (position < items.size())
+				{
+					items[position] = last;
+					positions[last] = position;
+				}
+			}
+		};
+
+		std::vector<Slot> m_slots;
+		std::vector<uint32_t> m_freeSlots;
+		std::unordered_map<std::type_index, std::unique_ptr<ViewBase>> m_views;
+	};
+}
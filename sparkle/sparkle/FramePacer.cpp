@@ -0,0 +1,78 @@
+#include "FramePacer.h"
+
+#include <cmath>
+#include <thread>
+#include <algorithm>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <timeapi.h>
+#endif
+
+namespace sparkle
+{
+	namespace
+	{
+		// Older samples fade out after about this many sleeps, so the estimate follows changes in system load
+		const int k_maxSleepSamples = 200;
+	}
+
+	FramePacer::FramePacer() : m_deadline(Clock::now()), m_sleepMean(k_sleepStep.count())
+	{
+#ifdef _WIN32
+		// The default scheduler tick of ~15.6 ms makes sleeps far too coarse for frame pacing
+		timeBeginPeriod(1);
+#endif
+	}
+
+	FramePacer::~FramePacer()
+	{
+#ifdef _WIN32
+		timeEndPeriod(1);
+#endif
+	}
+
+	void FramePacer::Wait(double frameRate)
+	{
+		const auto now = Clock::now();
+		if (frameRate <= 0.0)
+		{
+			m_deadline = now;
+			return;
+		}
+
+		const auto interval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / frameRate));
+		m_deadline += interval;
+		if (m_deadline + interval < now)
+		{
+			m_deadline = now;
+			return;
+		}
+
+		// Sleep while even a slow sleep ends before the deadline
+		const auto sleepBudget = std::chrono::duration<double>(m_sleepMean + m_sleepDeviation);
+		while (Clock::now() + sleepBudget < m_deadline)
+		{
+			const auto start = Clock::now();
+			std::this_thread::sleep_for(k_sleepStep);
+			RecordSleep(std::chrono::duration<double>(Clock::now() - start).count());
+		}
+
+		while (Clock::now() < m_deadline)
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	void FramePacer::RecordSleep(double seconds)
+	{
+		// Welford's running mean and variance, with the sample count capped to keep adapting
+		m_numSleeps = std::min(m_numSleeps + 1, k_maxSleepSamples);
+		const double delta = seconds - m_sleepMean;
+		m_sleepMean += delta / m_numSleeps;
+		m_sleepVariance += (delta * (seconds - m_sleepMean) - m_sleepVariance) / m_numSleeps;
+		m_sleepDeviation = std::sqrt(std::max(m_sleepVariance, 0.0));
+	}
+}
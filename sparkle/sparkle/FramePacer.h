@@ -0,0 +1,45 @@
+#pragma once
+
+#include <chrono>
+
+namespace sparkle
+{
+	// Limits the main loop to a target frame rate without burning a core.
+	// Most of the wait is spent sleeping; the last stretch, shorter than the measured oversleep of the OS timer,
+	// is spent spinning, so frames still end close to their deadline.
+	class FramePacer
+	{
+	public:
+		FramePacer();
+		FramePacer(const FramePacer&) = delete;
+		~FramePacer();
+
+		/// <summary>
+		/// Blocks until 1 / frameRate seconds after the previous deadline.
+		/// Frames that overrun by more than a whole interval restart the schedule instead of being made up for.
+		/// </summary>
+		/// <param name="frameRate">Frames per second, or 0 to return right away</param>
+		void Wait(double frameRate);
+
+		// Estimated time a short sleep overshoots by, in seconds
+		double timerSlack() const
+		{
+			return m_sleepMean + m_sleepDeviation - k_sleepStep.count();
+		}
+
+	private:
+		using Clock = std::chrono::steady_clock;
+
+		static constexpr std::chrono::duration<double> k_sleepStep = std::chrono::milliseconds(1);
+
+		void RecordSleep(double seconds);
+
+		Clock::time_point m_deadline;
+
+		// Running statistics of how long sleeping for k_sleepStep actually takes
+		double m_sleepMean;
+		double m_sleepDeviation = 0.0;
+		double m_sleepVariance = 0.0;
+		int m_numSleeps = 0;
+	};
+}
@@ -387,6 +387,13 @@ namespace sparkle
 			Global::input->ToggleOnKeyDown(GLFW_KEY_K, Global::gameState.drawParticles);
 			ImGui::Checkbox("Draw Wireframe (L)", &Global::gameState.renderWireframe);
 			Global::input->ToggleOnKeyDown(GLFW_KEY_L, Global::gameState.renderWireframe);
+			ImGui::Checkbox("VSync", &Global::gameState.vsync);
+			IMGUI_LEFT_LABEL(ImGui::SliderInt, "Frame Rate Limit", &Global::gameState.targetFrameRate, 0, 360, Global::gameState.targetFrameRate > 0 ? "%d" : "Off");
+			if (Global::gameState.targetFrameRate > 0)
+			{
+				// How much of each frame's wait the limiter spins instead of sleeping
+				ImGui::TextDisabled("Timer slack: %.2f ms", Global::game->framePacer().timerSlack() * 1000.0);
+			}
 			ImGui::Dummy(ImVec2(0.0f, 10.0f));
 		}
 
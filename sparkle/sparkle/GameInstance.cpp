@@ -9,6 +9,8 @@
 #include "SpEngine.h"
 #include "Timer.h"
 #include "GUI.h"
+#include "Resource.h"
+#include "JobSystem.h"
 
 namespace sparkle
 {
@@ -17,16 +19,33 @@ namespace sparkle
 		Global::game = this;
 
 		m_window = window;
+		glfwGetWindowSize(m_window, &m_windowSize.x, &m_windowSize.y);
 		m_gui = gui;
 		m_renderPipeline = std::make_shared<RenderPipeline>();
 		m_timer = std::make_shared<Timer>();
 
+		const auto& options = Global::engine->options();
+		Timer::UseSimulatedTime(options.headless || options.benchmark.enabled);
+		if (options.headless)
+		{
+			if (options.renderOffscreen)
+			{
+				m_renderPipeline->CreateOffscreenTarget(m_windowSize);
+			}
+		}
+		else
+		{
+			m_vsync = Global::gameState.vsync;
+			glfwSwapInterval(m_vsync ? 1 : 0);
+		}
+
 		Timer::StartTimer("GAME_INSTANCE_INIT");
 	}
 
 	std::shared_ptr<Actor> GameInstance::AddActor(std::shared_ptr<Actor> actor)
 	{
 		m_actors.push_back(actor);
+		actor->SetRegistry(&m_componentRegistry);
 		return actor;
 	}
 
@@ -69,11 +88,14 @@ namespace sparkle
 		return m_renderPipeline->depthTex;
 	}
 
+	void GameInstance::Quit()
+	{
+		glfwSetWindowShouldClose(m_window, true);
+	}
+
 	glm::ivec2 GameInstance::windowSize()
 	{
-		glm::ivec2 result;
-		glfwGetWindowSize(m_window, &result.x, &result.y);
-		return result;
+		return m_windowSize;
 	}
 
 	bool GameInstance::windowMinimized()
@@ -130,27 +152,49 @@ namespace sparkle
 	{
 		double initTime = Timer::EndTimer("GAME_INSTANCE_INIT") * 1000.0;
 		fmt::print("Info(GameInstance): Initialization success within {:.2f} ms. Enter main loop.\n", initTime);
+		const auto& options = Global::engine->options();
+		const bool renders = Global::engine->renders();
+		unsigned int numFrames = 0;
+
 		// render loop
 		while (!glfwWindowShouldClose(m_window) && !pendingReset)
 		{
+			if (options.maxFrames > 0 && numFrames++ >= options.maxFrames)
+			{
+				break;
+			}
+
+			// Queried once per frame; cameras rebuild their projection only when it changes
+			glfwGetWindowSize(m_window, &m_windowSize.x, &m_windowSize.y);
 			if (windowMinimized())
 			{
-				glfwPollEvents();
+				glfwWaitEventsTimeout(Global::Config::minimizedWaitSeconds);
 				continue;
 			}
 			// Input
+			Global::input->BeginFrame();
+			if (Global::input->replayFinished())
+			{
+				glfwSetWindowShouldClose(m_window, true);
+				break;
+			}
 			ProcessKeyboard(m_window);
 
 			// Init
-			glClearColor(clearColor.x, clearColor.y, clearColor.z, clearColor.w);
-			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-			glPolygonMode(GL_FRONT_AND_BACK, Global::gameState.renderWireframe ? GL_LINE : GL_FILL);
+			Global::frameStats = SpFrameStats();
+			if (renders)
+			{
+				glBindFramebuffer(GL_FRAMEBUFFER, m_renderPipeline->targetFrameBuffer);
+				glClearColor(clearColor.x, clearColor.y, clearColor.z, clearColor.w);
+				glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+				glPolygonMode(GL_FRONT_AND_BACK, Global::gameState.renderWireframe ? GL_LINE : GL_FILL);
+			}
 
 			Timer::StartTimer("CPU_TIME");
 			Timer::UpdateDeltaTime();
 
 			// Logic Updates
-			if (!Global::gameState.hideGUI)
+			if (m_gui && !Global::gameState.hideGUI)
 			{
 				m_gui->OnUpdate();
 			}
@@ -158,12 +202,11 @@ namespace sparkle
 			if (!Global::gameState.pause)
 			{
 				Timer::NextFrame();
-				if (Timer::NextFixedFrame())
+				// As many fixed steps as the frame time covers, so the simulation rate doesn't depend on the frame rate
+				while (Timer::NextFixedFrame())
 				{
-					for (const auto& go : m_actors)
-					{
-						go->FixedUpdate();
-					}
+					Transform::SaveFixedState();
+					UpdateActors(true);
 
 					animationUpdate.Invoke();
 
@@ -171,34 +214,78 @@ namespace sparkle
 					{
 						Global::gameState.pause = true;
 						Global::gameState.step = false;
+						break;
 					}
 				}
 
-				for (const auto& go : m_actors)
-				{
-					go->Update();
-				}
+				UpdateActors(false);
 			}
 
-			Global::input->OnUpdate();
-
 			godUpdate.Invoke();
 
+			// Everything that moved this frame, in one pass before rendering reads the matrices
+			Transform::UpdateMatrices(Timer::fixedAlpha());
+
+			Resource::ProcessUploads(Global::Config::uploadBudgetMs);
+
 			Timer::EndTimer("CPU_TIME");
 
 			// Render
-			m_renderPipeline->Render();
-			if (!Global::gameState.hideGUI)
+			onBeginRender.Invoke();
+			if (renders)
+			{
+				m_renderPipeline->Render();
+			}
+			if (m_gui && !Global::gameState.hideGUI)
 			{
 				m_gui->Render();
 			}
 
-			// Check and call events and swap the buffers
-			glfwSwapBuffers(m_window);
+			onEndFrame.Invoke();
+			Global::input->EndFrame();
+
+			if (!options.headless)
+			{
+				Present();
+			}
+		}
+	}
+
+	void GameInstance::Present()
+	{
+		// Check and call events and swap the buffers
+		if (Global::gameState.vsync != m_vsync)
+		{
+			m_vsync = Global::gameState.vsync;
+			glfwSwapInterval(m_vsync ? 1 : 0);
+		}
+		glfwSwapBuffers(m_window);
+
+		m_framePacer.Wait(Global::gameState.targetFrameRate);
+		if (Global::gameState.pause)
+		{
+			// Nothing moves on its own while paused, so only redraw at a low rate unless there is input
+			glfwWaitEventsTimeout(1.0 / Global::Config::pausedFrameRate);
+		}
+		else
+		{
 			glfwPollEvents();
 		}
 	}
 
+	void GameInstance::UpdateActors(bool fixedUpdate)
+	{
+		// Thread-safe components of all actors first, in parallel; then the rest in actor order on this thread
+		Global::jobs->ParallelFor(static_cast<unsigned int>(m_actors.size()), [this, fixedUpdate](unsigned int i) {
+			fixedUpdate ? m_actors[i]->FixedUpdate(true) : m_actors[i]->Update(true);
+			}, Global::Config::actorsPerUpdateJob);
+
+		for (const auto& go : m_actors)
+		{
+			fixedUpdate ? go->FixedUpdate(false) : go->Update(false);
+		}
+	}
+
 	void GameInstance::Finalize()
 	{
 		for (const auto& go : m_actors)
@@ -10,6 +10,8 @@
 #include <glm.hpp>
 
 #include "Component.h"
+#include "ComponentRegistry.h"
+#include "FramePacer.h"
 #include "Common.h"
 
 namespace sparkle
@@ -36,27 +38,33 @@ namespace sparkle
 		void ProcessScroll(GLFWwindow* window, double xoffset, double yoffset);
 		void ProcessKeyboard(GLFWwindow* window);
 
+		/// <summary>
+		/// All components of type T (or derived from it) on the actors of this game.
+		/// The returned array is cached and kept up to date as components are added or removed;
+		/// don't add or remove components while iterating it.
+		/// </summary>
 		template <typename T>
-		std::enable_if_t<std::is_base_of<Component, T>::value, std::vector<T*>> FindComponents()
+		std::enable_if_t<std::is_base_of<Component, T>::value, const std::vector<T*>&> FindComponents()
 		{
-			std::vector<T*> result;
-			for (auto actor : m_actors)
-			{
-				// TODO This throws errors when compiled aginst C++20 standard, unsure why?
-				// In 20, it would be better to convert this fn (and the Actor fn) as concepts/constraints.
-				// Maybe we should make that upgrade (I do love concepts/constraints...) but for now let's
-				// compile with C++17, and we can do that upgrade later.
-				auto component = actor->GetComponents<T>();
-				if (component.size() > 0)
-				{
-					result.insert(result.end(), component.begin(), component.end());
-				}
-			}
-			return result;
+			return m_componentRegistry.View<T>();
+		}
+
+		RenderPipeline* renderPipeline()
+		{
+			return m_renderPipeline.get();
+		}
+
+		const FramePacer& framePacer() const
+		{
+			return m_framePacer;
 		}
 
 		unsigned int depthFrameBuffer();
 		unsigned int depthTex();
+		// Leaves the main loop after the current frame
+		void Quit();
+
+		// Size of the window as of the start of the current frame
 		glm::ivec2 windowSize();
 		bool windowMinimized();
 
@@ -65,6 +73,8 @@ namespace sparkle
 		SpCallback<void()> animationUpdate;
 		SpCallback<void()> godUpdate; // update when main logic is paused (for debugging purposes)
 		SpCallback<void()> onFinalize;
+		SpCallback<void()> onBeginRender;
+		SpCallback<void()> onEndFrame; // after rendering, before presenting
 
 		bool pendingReset = false;
 		glm::vec4 clearColor = glm::vec4(0.0f);
@@ -72,12 +82,20 @@ namespace sparkle
 	private:
 		void Initialize();
 		void MainLoop();
+		// Swaps buffers, waits for the next frame and processes window events
+		void Present();
+		void UpdateActors(bool fixedUpdate);
 		void Finalize();
 
 		GLFWwindow* m_window = nullptr;
+		FramePacer m_framePacer;
+		bool m_vsync = false;
+		glm::ivec2 m_windowSize = glm::ivec2(0);
 		std::shared_ptr<GUI> m_gui;
 		std::shared_ptr<Timer> m_timer;
 
+		// Declared before m_actors, so actors are destroyed first
+		ComponentRegistry m_componentRegistry;
 		std::vector<std::shared_ptr<Actor>> m_actors;
 		std::shared_ptr<RenderPipeline> m_renderPipeline;
 	};
@@ -11,6 +11,7 @@ namespace sparkle
 	class Input;
 	class SpEngine;
 	class Camera;
+	class JobSystem;
 
 	namespace Global
 	{
@@ -18,10 +19,12 @@ namespace sparkle
 		inline GameInstance* game;
 		inline Camera* camera;
 		inline Input* input;
+		inline JobSystem* jobs;
 		inline std::vector<Light*> lights;
 
 		inline SpGameState gameState;
 		inline SpSimParams simParams;
+		inline SpFrameStats frameStats;
 
 		namespace Config
 		{
@@ -34,6 +37,30 @@ namespace sparkle
 
 			const unsigned int shadowWidth = 1024;
 			const unsigned int shadowHeight = 1024;
+
+			// Time per frame the main thread may spend uploading asynchronously loaded assets
+			const double uploadBudgetMs = 2.0;
+
+			// Frame rate while paused; input events still wake the main loop right away
+			const double pausedFrameRate = 30.0;
+			// Longest the main loop sleeps between checks while the window is minimized
+			const double minimizedWaitSeconds = 0.25;
+
+			// Input events kept per frame; more than this between two frames are dropped
+			const unsigned int inputEventsPerFrame = 256;
+
+			// Fixed updates run per frame at most; beyond that the simulation falls behind real time
+			const int maxFixedStepsPerFrame = 4;
+
+			// Number of actors per job when updating thread-safe components in parallel
+			const unsigned int actorsPerUpdateJob = 64;
+
+			// Screen-space error in pixels a mesh LOD may have at its distance to the camera
+			const float lodPixelError = 1.0f;
+			// Fraction by which a coarser LOD's error must undercut lodPixelError before switching to it, to avoid flickering
+			const float lodHysteresis = 0.25f;
+			// Number of LODs coarser than the main pass used when rendering shadows
+			const unsigned int shadowLodBias = 1;
 		}
 	}
 }
\ No newline at end of file
@@ -1,60 +1,282 @@
 #include "Input.h"
 
+#include <cstring>
+
+#include <fmt/core.h>
+
+#include "Timer.h"
+
 namespace sparkle
 {
+	namespace
+	{
+		const char k_recordingMagic[4] = { 'S', 'P', 'I', 'N' };
+		const uint32_t k_recordingVersion = 3;
+
+		// Callbacks installed before ours, i.e. the GUI's, which still get every event
+		GLFWkeyfun s_previousKeyCallback = nullptr;
+		GLFWmousebuttonfun s_previousMouseButtonCallback = nullptr;
+		GLFWcursorposfun s_previousCursorPosCallback = nullptr;
+		GLFWscrollfun s_previousScrollCallback = nullptr;
+		GLFWcharfun s_previousCharCallback = nullptr;
+
+		template <typename T>
+		void WriteField(std::ofstream& file, const T& value)
+		{
+			file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+		}
+
+		template <typename T>
+		void ReadField(std::ifstream& file, T& value)
+		{
+			file.read(reinterpret_cast<char*>(&value), sizeof(value));
+		}
+	}
+
 	Input::Input(GLFWwindow* window)
 	{
 		m_window = window;
 		Global::input = this;
-		memset(m_keyOnce, 0, sizeof(m_keyOnce));
-		memset(m_keyNow, 0, sizeof(m_keyNow));
+
+		double x, y;
+		glfwGetCursorPos(m_window, &x, &y);
+		m_cursorPos = glm::vec2(x, y);
+
+		// The state follows the events instead of being polled from GLFW, so a replay can stand in for the user
+		s_previousKeyCallback = glfwSetKeyCallback(window, [](GLFWwindow* window, int key, int scancode, int action, int mods) {
+			if (key >= 0 && key <= GLFW_KEY_LAST)
+			{
+				Global::input->OnEvent({ InputEventType::Key, (uint8_t)action, (uint16_t)mods, (uint32_t)key });
+			}
+			});
+		s_previousMouseButtonCallback = glfwSetMouseButtonCallback(window, [](GLFWwindow* window, int button, int action, int mods) {
+			if (button >= 0 && button <= GLFW_MOUSE_BUTTON_LAST)
+			{
+				Global::input->OnEvent({ InputEventType::MouseButton, (uint8_t)action, (uint16_t)mods, (uint32_t)button });
+			}
+			});
+		s_previousCursorPosCallback = glfwSetCursorPosCallback(window, [](GLFWwindow* window, double xpos, double ypos) {
+			Global::input->OnEvent({ InputEventType::CursorPos, 0, 0, 0, 0, xpos, ypos });
+			});
+		s_previousScrollCallback = glfwSetScrollCallback(window, [](GLFWwindow* window, double xoffset, double yoffset) {
+			Global::input->OnEvent({ InputEventType::Scroll, 0, 0, 0, 0, xoffset, yoffset });
+			});
+		s_previousCharCallback = glfwSetCharCallback(window, [](GLFWwindow* window, unsigned int codepoint) {
+			Global::input->OnEvent({ InputEventType::Char, 0, 0, codepoint });
+			});
 	}
 
-	void Input::OnUpdate()
+	bool Input::StartRecording(const std::string& path)
 	{
-		std::swap(m_keyOnce, m_keyNow);
+		m_recording.open(path, std::ios::binary);
+		if (!m_recording)
+		{
+			fmt::print("Error(Input): Cannot write recording to {}.\n", path);
+			return false;
+		}
+		m_recording.write(k_recordingMagic, sizeof(k_recordingMagic));
+		m_recording.write(reinterpret_cast<const char*>(&k_recordingVersion), sizeof(k_recordingVersion));
+		fmt::print("Info(Input): Recording input to {}.\n", path);
+		return true;
 	}
 
-	bool Input::GetKey(int key)
+	bool Input::StartReplay(const std::string& path)
 	{
-		return glfwGetKey(m_window, key) == GLFW_PRESS;
+		m_replay.open(path, std::ios::binary);
+		char magic[sizeof(k_recordingMagic)] = {};
+		uint32_t version = 0;
+		m_replay.read(magic, sizeof(magic));
+		m_replay.read(reinterpret_cast<char*>(&version), sizeof(version));
+		if (!m_replay || memcmp(magic, k_recordingMagic, sizeof(magic)) != 0 || version != k_recordingVersion)
+		{
+			fmt::print("Error(Input): {} is not an input recording of this version.\n", path);
+			m_replay.close();
+			return false;
+		}
+		m_hasNextEvent = ReadEvent(m_nextEvent);
+		fmt::print("Info(Input): Replaying input from {}.\n", path);
+		return true;
 	}
 
-	bool Input::GetKeyDown(int key)
+	void Input::WriteEvent(const InputEvent& e)
 	{
-		m_keyNow[key] = GetKey(key);
-		return !m_keyOnce[key] && m_keyNow[key];
+		// Field by field, so the padding of InputEvent never ends up in the file
+		WriteField(m_recording, e.type);
+		WriteField(m_recording, e.action);
+		WriteField(m_recording, e.mods);
+		WriteField(m_recording, e.code);
+		WriteField(m_recording, e.frame);
+		WriteField(m_recording, e.x);
+		WriteField(m_recording, e.y);
 	}
 
-	void Input::ToggleOnKeyDown(int key, bool& variable)
+	bool Input::ReadEvent(InputEvent& e)
 	{
-		if (GetKeyDown(key))
-		{
-			variable = !variable;
-		}
+		ReadField(m_replay, e.type);
+		ReadField(m_replay, e.action);
+		ReadField(m_replay, e.mods);
+		ReadField(m_replay, e.code);
+		ReadField(m_replay, e.frame);
+		ReadField(m_replay, e.x);
+		ReadField(m_replay, e.y);
+		return (bool)m_replay;
+	}
+
+	void Input::StopReplay()
+	{
+		m_replay.close();
+		m_hasNextEvent = false;
+		m_replayFinished = true;
+		fmt::print("Info(Input): Replay finished after {} frames.\n", m_frame);
 	}
 
-	bool Input::GetKeyUp(int key)
+	void Input::BeginFrame()
 	{
-		m_keyNow[key] = GetKey(key);
-		return m_keyOnce[key] && !m_keyNow[key];
+		while (replaying())
+		{
+			if (!m_hasNextEvent || m_nextEvent.frame > m_frame)
+			{
+				// Only complete frames are replayed
+				StopReplay();
+				break;
+			}
+			const InputEvent e = m_nextEvent;
+			m_hasNextEvent = ReadEvent(m_nextEvent);
+			if (e.type == InputEventType::FrameEnd)
+			{
+				Timer::OverrideDeltaTime((float)e.x);
+				m_expectedPhysicsFrame = (int)e.y;
+				break;
+			}
+			Dispatch(e);
+		}
+
+		m_keys = m_keysHeld;
+		m_keysDown = m_keysPressed;
+		m_keysUp = m_keysReleased;
+		m_mouse = m_mouseHeld;
+		m_mouseDown = m_mousePressed;
+		m_mouseUp = m_mouseReleased;
+		m_keysPressed.reset();
+		m_keysReleased.reset();
+		m_mousePressed.reset();
+		m_mouseReleased.reset();
+
+		m_numFrameEvents = m_numPendingEvents;
+		m_numPendingEvents = 0;
 	}
 
-	bool Input::GetMouse(int button)
+	void Input::EndFrame()
 	{
-		int state = glfwGetMouseButton(m_window, button);
-		return state == GLFW_PRESS;
+		if (m_recording.is_open())
+		{
+			WriteEvent({ InputEventType::FrameEnd, 0, 0, 0, m_frame, Timer::deltaTime(), (double)Timer::physicsFrameCount() });
+		}
+		if (replaying() && m_expectedPhysicsFrame != Timer::physicsFrameCount() && !m_reportedDivergence)
+		{
+			fmt::print("Warning(Input): Replay diverged from the recording at frame {} (fixed frame {} instead of {}).\n",
+				m_frame, Timer::physicsFrameCount(), m_expectedPhysicsFrame);
+			m_reportedDivergence = true;
+		}
+		m_frame++;
+
+		// Events of the frame are consumed; the ring is free for the next one
+		m_firstFrameEvent = (m_firstFrameEvent + m_numFrameEvents) % k_maxEvents;
+		m_numFrameEvents = 0;
 	}
 
-	bool Input::GetMouseDown(int button)
+	void Input::OnEvent(const InputEvent& e)
 	{
-		m_keyNow[button] = GetMouse(button);
-		return !m_keyOnce[button] && m_keyNow[button];
+		// Live input is ignored while replaying, so it can't disturb the run
+		if (replaying())
+		{
+			return;
+		}
+		if (m_recording.is_open())
+		{
+			InputEvent recorded = e;
+			recorded.frame = m_frame;
+			WriteEvent(recorded);
+		}
+		Dispatch(e);
 	}
 
-	bool Input::GetMouseUp(int button)
+	void Input::Dispatch(const InputEvent& e)
 	{
-		m_keyNow[button] = GetMouse(button);
-		return m_keyOnce[button] && !m_keyNow[button];
+		if (m_numFrameEvents + m_numPendingEvents < k_maxEvents)
+		{
+			m_events[(m_firstFrameEvent + m_numFrameEvents + m_numPendingEvents) % k_maxEvents] = e;
+			m_numPendingEvents++;
+		}
+		else if (!m_reportedDroppedEvents)
+		{
+			fmt::print("Warning(Input): More than {} input events in a frame; the rest are dropped from the event queue.\n", k_maxEvents);
+			m_reportedDroppedEvents = true;
+		}
+
+		switch (e.type)
+		{
+		case InputEventType::Key:
+			if (e.action == GLFW_PRESS)
+			{
+				m_keysHeld.set(e.code);
+				m_keysPressed.set(e.code);
+			}
+			else if (e.action == GLFW_RELEASE)
+			{
+				m_keysHeld.reset(e.code);
+				m_keysReleased.set(e.code);
+			}
+			if (s_previousKeyCallback)
+			{
+				s_previousKeyCallback(m_window, e.code, glfwGetKeyScancode(e.code), e.action, e.mods);
+			}
+			break;
+		case InputEventType::MouseButton:
+			if (e.action == GLFW_PRESS)
+			{
+				m_mouseHeld.set(e.code);
+				m_mousePressed.set(e.code);
+			}
+			else if (e.action == GLFW_RELEASE)
+			{
+				m_mouseHeld.reset(e.code);
+				m_mouseReleased.set(e.code);
+			}
+			if (s_previousMouseButtonCallback)
+			{
+				s_previousMouseButtonCallback(m_window, e.code, e.action, e.mods);
+			}
+			break;
+		case InputEventType::CursorPos:
+			m_cursorPos = glm::vec2(e.x, e.y);
+			if (s_previousCursorPosCallback)
+			{
+				s_previousCursorPosCallback(m_window, e.x, e.y);
+			}
+			if (Global::game)
+			{
+				Global::game->ProcessMouse(m_window, e.x, e.y);
+			}
+			break;
+		case InputEventType::Scroll:
+			if (s_previousScrollCallback)
+			{
+				s_previousScrollCallback(m_window, e.x, e.y);
+			}
+			if (Global::game)
+			{
+				Global::game->ProcessScroll(m_window, e.x, e.y);
+			}
+			break;
+		case InputEventType::Char:
+			if (s_previousCharCallback)
+			{
+				s_previousCharCallback(m_window, e.code);
+			}
+			break;
+		default:
+			break;
+		}
 	}
-}
\ No newline at end of file
+}
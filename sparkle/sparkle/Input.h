@@ -1,5 +1,11 @@
 #pragma once
 
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <string>
+#include <fstream>
+
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
@@ -8,40 +14,185 @@
 
 namespace sparkle
 {
+	enum class InputEventType : uint8_t
+	{
+		Key,
+		MouseButton,
+		CursorPos,
+		Scroll,
+		// Text input; code holds the Unicode code point
+		Char,
+		// Closes a frame in recordings; x holds its delta time and y the fixed frame count at its end
+		FrameEnd,
+	};
+
+	// One GLFW input event. Recordings are a header followed by these, written field by field in declaration order.
+	struct InputEvent
+	{
+		InputEventType type;
+		// GLFW_PRESS, GLFW_RELEASE or GLFW_REPEAT for keys and mouse buttons
+		uint8_t action = 0;
+		// GLFW_MOD_* bits held during key and mouse button events
+		uint16_t mods = 0;
+		// Key, mouse button or code point
+		uint32_t code = 0;
+		// Frame the event is handled in
+		uint32_t frame = 0;
+		// Cursor position or scroll offset
+		double x = 0.0;
+		double y = 0.0;
+	};
+
+	// The recording format stores the fields without padding; a new field needs WriteEvent() and ReadEvent() updated
+	static_assert(sizeof(InputEvent) == 32, "InputEvent changed; update the recording format and its version");
+
 	class Input
 	{
 	public:
 		Input(GLFWwindow* window);
 
-		void OnUpdate();
+		/// <summary>
+		/// Starts a frame: replays its events, if replaying, and takes the snapshot of keys and mouse buttons
+		/// that all queries of the frame read. Call once per frame before any query.
+		/// </summary>
+		void BeginFrame();
+
+		// Closes the frame in the recording, or checks that the replay hasn't diverged from it
+		void EndFrame();
+
+		/// <summary>
+		/// Writes all input events from the next frame on, with the frames they arrive in and each frame's delta time, to path.
+		/// </summary>
+		bool StartRecording(const std::string& path);
+
+		/// <summary>
+		/// Replaces live input by a recording from StartRecording. Frames take the delta times of the recording,
+		/// so the replay steps through the same frames and fixed updates as the recorded run.
+		/// The GUI still polls the live cursor position, modifier keys and window focus from GLFW, so moving the mouse
+		/// or changing focus during a replay can change what the GUI does; the game's own input is unaffected.
+		/// </summary>
+		bool StartReplay(const std::string& path);
+
+		bool replaying() const
+		{
+			return m_replay.is_open();
+		}
+
+		// True once all frames of the replay have been played
+		bool replayFinished() const
+		{
+			return m_replayFinished;
+		}
 
 		// Returns true while the user holds down the key
-		bool GetKey(int key);
+		bool GetKey(int key) const
+		{
+			return m_keys[key];
+		}
 
 		// Returns true during the frame the user starts pressing down the key
-		bool GetKeyDown(int key);
+		bool GetKeyDown(int key) const
+		{
+			return m_keysDown[key];
+		}
 
-		void ToggleOnKeyDown(int key, bool& variable);
+		void ToggleOnKeyDown(int key, bool& variable) const
+		{
+			if (GetKeyDown(key))
+			{
+				variable = !variable;
+			}
+		}
 
 		// Returns true during the frame the user releases the key
-		bool GetKeyUp(int key);
+		bool GetKeyUp(int key) const
+		{
+			return m_keysUp[key];
+		}
+
+		bool GetMouse(int button) const
+		{
+			return m_mouse[button];
+		}
 
-		bool GetMouse(int button);
+		bool GetMouseDown(int button) const
+		{
+			return m_mouseDown[button];
+		}
+
+		bool GetMouseUp(int button) const
+		{
+			return m_mouseUp[button];
+		}
 
-		bool GetMouseDown(int button);
+		glm::vec2 GetMousePos() const
+		{
+			return m_cursorPos;
+		}
 
-		bool GetMouseUp(int button);
+		// Number of input events that arrived for the current frame
+		unsigned int numEvents() const
+		{
+			return m_numFrameEvents;
+		}
 
-		glm::vec2 GetMousePos()
+		// Input events of the current frame in the order they arrived, for systems that care about more than the
+		// state at the start of the frame, such as a key pressed and released within one frame, or text input
+		const InputEvent& GetEvent(unsigned int index) const
 		{
-			double x, y;
-			glfwGetCursorPos(m_window, &x, &y);
-			return glm::vec2(x, y);
+			return m_events[(m_firstFrameEvent + index) % k_maxEvents];
 		}
 
 	private:
+		static constexpr unsigned int k_maxEvents = Global::Config::inputEventsPerFrame;
+		static constexpr int k_numKeys = GLFW_KEY_LAST + 1;
+		static constexpr int k_numMouseButtons = GLFW_MOUSE_BUTTON_LAST + 1;
+
+		// Called by the GLFW callbacks
+		void OnEvent(const InputEvent& e);
+		// Updates the state from e, queues it for the next frame and passes it on to the GUI and the game
+		void Dispatch(const InputEvent& e);
+		void WriteEvent(const InputEvent& e);
+		bool ReadEvent(InputEvent& e);
+		void StopReplay();
+
 		GLFWwindow* m_window;
-		char m_keyOnce[GLFW_KEY_LAST + 1];
-		char m_keyNow[GLFW_KEY_LAST + 1];
+
+		// Snapshot of the current frame, which all queries read
+		std::bitset<k_numKeys> m_keys;
+		std::bitset<k_numKeys> m_keysDown;
+		std::bitset<k_numKeys> m_keysUp;
+		std::bitset<k_numMouseButtons> m_mouse;
+		std::bitset<k_numMouseButtons> m_mouseDown;
+		std::bitset<k_numMouseButtons> m_mouseUp;
+
+		// State as of the latest event, and the presses and releases since the last snapshot
+		std::bitset<k_numKeys> m_keysHeld;
+		std::bitset<k_numKeys> m_keysPressed;
+		std::bitset<k_numKeys> m_keysReleased;
+		std::bitset<k_numMouseButtons> m_mouseHeld;
+		std::bitset<k_numMouseButtons> m_mousePressed;
+		std::bitset<k_numMouseButtons> m_mouseReleased;
+		glm::vec2 m_cursorPos = glm::vec2(0.0f);
+
+		// Events of the current frame, followed by those that arrived since it began
+		std::array<InputEvent, k_maxEvents> m_events;
+		unsigned int m_firstFrameEvent = 0;
+		unsigned int m_numFrameEvents = 0;
+		unsigned int m_numPendingEvents = 0;
+		bool m_reportedDroppedEvents = false;
+
+		// Frames begun so far; events arriving between frames belong to the next one
+		uint32_t m_frame = 0;
+
+		std::ofstream m_recording;
+		std::ifstream m_replay;
+		// Next event of the replay, read ahead to see which frame it belongs to
+		InputEvent m_nextEvent;
+		bool m_hasNextEvent = false;
+		bool m_replayFinished = false;
+		// Fixed frame count the recording reached at the end of the current frame
+		int m_expectedPhysicsFrame = -1;
+		bool m_reportedDivergence = false;
 	};
-}
\ No newline at end of file
+}
@@ -0,0 +1,280 @@
+#include "JobSystem.h"
+
+namespace sparkle
+{
+	namespace
+	{
+		thread_local const JobSystem* t_owner = nullptr;
+		thread_local int t_workerIndex = -1;
+	}
+
+	JobSystem::JobSystem(unsigned int numThreads)
+	{
+		for (unsigned int i = 0; i < numThreads; i++)
+		{
+			m_workers.push_back(std::make_unique<Worker>());
+		}
+		// Start threads only once all deques exist, as they steal from each other
+		for (unsigned int i = 0; i < numThreads; i++)
+		{
+			m_workers[i]->thread = std::thread([this, i]() { WorkerLoop(i); });
+		}
+	}
+
+	JobSystem::~JobSystem()
+	{
+		{
+			// Queued loads would only delay the shutdown
+			std::lock_guard<std::mutex> lock(m_sharedMutex);
+			m_numQueued -= static_cast<int>(m_backgroundTasks.size());
+			m_backgroundTasks.clear();
+		}
+		{
+			std::lock_guard<std::mutex> lock(m_sleepMutex);
+			m_stopping = true;
+		}
+		m_wake.notify_all();
+		for (auto& worker : m_workers)
+		{
+			worker->thread.join();
+		}
+	}
+
+	JobSystem::JobHandle JobSystem::Schedule(std::function<void()> task, const std::vector<JobHandle>& dependencies)
+	{
+		auto job = std::make_shared<Job>();
+		job->task = std::move(task);
+		job->numPendingDependencies += static_cast<int>(dependencies.size());
+
+		for (const auto& dependency : dependencies)
+		{
+			std::lock_guard<std::mutex> lock(dependency->mutex);
+			if (dependency->finished)
+			{
+				job->numPendingDependencies--;
+			}
+			else
+			{
+				dependency->continuations.push_back(job);
+			}
+		}
+
+		if (--job->numPendingDependencies == 0)
+		{
+			Push(job);
+		}
+		return job;
+	}
+
+	void JobSystem::Wait(const JobHandle& job)
+	{
+		while (true)
+		{
+			{
+				std::lock_guard<std::mutex> lock(job->mutex);
+				if (job->finished)
+				{
+					return;
+				}
+			}
+
+			if (JobHandle other = TryTake())
+			{
+				Run(other);
+			}
+			else
+			{
+				std::this_thread::yield();
+			}
+		}
+	}
+
+	void JobSystem::ParallelFor(unsigned int count, const std::function<void(unsigned int)>& body, unsigned int grainSize)
+	{
+		grainSize = std::max(grainSize, 1u);
+		const unsigned int numChunks = (count + grainSize - 1) / grainSize;
+		if (numChunks == 0)
+		{
+			return;
+		}
+
+		std::atomic<unsigned int> nextChunk = 0;
+		auto work = [&nextChunk, &body, numChunks, count, grainSize]() {
+			unsigned int chunk;
+			while ((chunk = nextChunk++) < numChunks)
+			{
+				const unsigned int end = std::min(count, (chunk + 1) * grainSize);
+				for (unsigned int i = chunk * grainSize; i < end; i++)
+				{
+					body(i);
+				}
+			}
+		};
+
+		// Helpers which start after the caller took the last chunk return right away
+		std::vector<JobHandle> helpers;
+		const unsigned int numHelpers = std::min(numThreads(), numChunks - 1);
+		for (unsigned int i = 0; i < numHelpers; i++)
+		{
+			helpers.push_back(Schedule(work));
+		}
+		work();
+		for (const auto& helper : helpers)
+		{
+			Wait(helper);
+		}
+	}
+
+	void JobSystem::Enqueue(std::function<void()> task)
+	{
+		// Counted before it becomes visible, so the count never drops below the number of queued items
+		m_numQueued++;
+		{
+			std::lock_guard<std::mutex> lock(m_sharedMutex);
+			m_backgroundTasks.push_back(std::move(task));
+		}
+		Notify();
+	}
+
+	void JobSystem::WorkerLoop(unsigned int index)
+	{
+		t_owner = this;
+		t_workerIndex = static_cast<int>(index);
+
+		while (true)
+		{
+			if (JobHandle job = TryTake())
+			{
+				Run(job);
+				continue;
+			}
+
+			std::function<void()> task;
+			{
+				std::lock_guard<std::mutex> lock(m_sharedMutex);
+				if (!m_backgroundTasks.empty())
+				{
+					task = std::move(m_backgroundTasks.front());
+					m_backgroundTasks.pop_front();
+					m_numQueued--;
+				}
+			}
+			if (task)
+			{
+				task();
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock(m_sleepMutex);
+			m_wake.wait(lock, [this]() { return m_stopping || m_numQueued > 0; });
+			if (m_stopping && m_numQueued == 0)
+			{
+				return;
+			}
+		}
+	}
+
+	void JobSystem::Push(JobHandle job)
+	{
+		m_numQueued++;
+		const int index = CurrentWorker();
+		if (index >= 0)
+		{
+			std::lock_guard<std::mutex> lock(m_workers[index]->mutex);
+			m_workers[index]->jobs.push_back(std::move(job));
+		}
+		else
+		{
+			std::lock_guard<std::mutex> lock(m_sharedMutex);
+			m_sharedJobs.push_back(std::move(job));
+		}
+		Notify();
+	}
+
+	JobSystem::JobHandle JobSystem::TryTake()
+	{
+		JobHandle result;
+		const int index = CurrentWorker();
+
+		// Newest job of our own deque first: its data is most likely still in cache
+		if (index >= 0)
+		{
+			Worker& worker = *m_workers[index];
+			std::lock_guard<std::mutex> lock(worker.mutex);
+			if (!worker.jobs.empty())
+			{
+				result = std::move(worker.jobs.back());
+				worker.jobs.pop_back();
+			}
+		}
+
+		// Then the oldest job of the other workers, starting with our neighbor so thieves spread out
+		const size_t numWorkers = m_workers.size();
+		const size_t first = (index >= 0) ? index + 1 : 0;
+		for (size_t i = 0; !result && i < numWorkers; i++)
+		{
+			const size_t victimIndex = (first + i) % numWorkers;
+			if (static_cast<int>(victimIndex) == index)
+			{
+				continue;
+			}
+			Worker& victim = *m_workers[victimIndex];
+			std::lock_guard<std::mutex> lock(victim.mutex);
+			if (!victim.jobs.empty())
+			{
+				result = std::move(victim.jobs.front());
+				victim.jobs.pop_front();
+			}
+		}
+
+		if (!result)
+		{
+			std::lock_guard<std::mutex> lock(m_sharedMutex);
+			if (!m_sharedJobs.empty())
+			{
+				result = std::move(m_sharedJobs.front());
+				m_sharedJobs.pop_front();
+			}
+		}
+
+		if (result)
+		{
+			m_numQueued--;
+		}
+		return result;
+	}
+
+	void JobSystem::Run(const JobHandle& job)
+	{
+		job->task();
+		job->task = nullptr;
+
+		std::vector<JobHandle> continuations;
+		{
+			std::lock_guard<std::mutex> lock(job->mutex);
+			job->finished = true;
+			continuations.swap(job->continuations);
+		}
+		for (auto& continuation : continuations)
+		{
+			if (--continuation->numPendingDependencies == 0)
+			{
+				Push(std::move(continuation));
+			}
+		}
+	}
+
+	void JobSystem::Notify()
+	{
+		// Taking the lock orders this against a worker checking m_numQueued before it sleeps
+		{
+			std::lock_guard<std::mutex> lock(m_sleepMutex);
+		}
+		m_wake.notify_one();
+	}
+
+	int JobSystem::CurrentWorker() const
+	{
+		return (t_owner == this) ? t_workerIndex : -1;
+	}
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+namespace sparkle
+{
+	// Work-stealing scheduler owned by the engine (Global::jobs) and shared by game updates, rendering and asset loading.
+	//
+	// Each worker thread has its own deque: it pushes and pops jobs at the back, while idle workers steal from the front.
+	// Jobs scheduled from other threads (e.g. the main thread) go to a shared queue that workers also steal from.
+	// Waiting threads help by running jobs, so scheduling and waiting from inside a job is fine.
+	//
+	// Long-running work that nobody waits on within the frame (asset loads) goes through Enqueue() instead;
+	// it only runs on workers with nothing else to do, so a waiting main thread never picks it up.
+	// None of the jobs may touch OpenGL.
+	class JobSystem
+	{
+	public:
+		struct Job;
+		using JobHandle = std::shared_ptr<Job>;
+
+		JobSystem(unsigned int numThreads = std::max(2u, std::thread::hardware_concurrency()) - 1);
+
+		JobSystem(const JobSystem&) = delete;
+
+		// Finishes all queued jobs and running background tasks, drops the background tasks that haven't started,
+		// then joins the workers.
+		~JobSystem();
+
+		/// <summary>
+		/// Runs task once all dependencies have finished.
+		/// </summary>
+		/// <returns>Handle to wait on, or to pass as a dependency of later jobs</returns>
+		JobHandle Schedule(std::function<void()> task, const std::vector<JobHandle>& dependencies = {});
+
+		// Returns once job has finished, running other jobs in the meantime.
+		void Wait(const JobHandle& job);
+
+		/// <summary>
+		/// Calls body(i) for every i in [0, count), in chunks of grainSize, and returns once all calls have finished.
+		/// The calling thread takes part in the work.
+		/// </summary>
+		void ParallelFor(unsigned int count, const std::function<void(unsigned int)>& body, unsigned int grainSize = 1);
+
+		// Queues a background task; see the class comment.
+		void Enqueue(std::function<void()> task);
+
+		// True once the system is shutting down; long background tasks check it to return early.
+		bool stopping() const
+		{
+			return m_stopping;
+		}
+
+		unsigned int numThreads() const
+		{
+			return static_cast<unsigned int>(m_workers.size());
+		}
+
+		struct Job
+		{
+			std::function<void()> task;
+			// Unfinished dependencies, plus one held by Schedule() until all of them are registered
+			std::atomic<int> numPendingDependencies = 1;
+
+			std::mutex mutex;
+			bool finished = false;
+			// Jobs depending on this one
+			std::vector<JobHandle> continuations;
+		};
+
+	private:
+		struct Worker
+		{
+			std::mutex mutex;
+			std::deque<JobHandle> jobs;
+			std::thread thread;
+		};
+
+		void WorkerLoop(unsigned int index);
+
+		// Makes a job whose dependencies have finished available for running.
+		void Push(JobHandle job);
+		JobHandle TryTake();
+		void Run(const JobHandle& job);
+		void Notify();
+
+		// Index of the calling thread in m_workers, or -1 for threads not owned by this system
+		int CurrentWorker() const;
+
+		std::vector<std::unique_ptr<Worker>> m_workers;
+
+		std::mutex m_sharedMutex;
+		std::deque<JobHandle> m_sharedJobs;
+		std::deque<std::function<void()>> m_backgroundTasks;
+
+		// Queued jobs and background tasks; idle workers sleep while it is zero.
+		std::atomic<int> m_numQueued = 0;
+		std::mutex m_sleepMutex;
+		std::condition_variable m_wake;
+		std::atomic<bool> m_stopping = false;
+	};
+}
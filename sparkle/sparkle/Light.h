@@ -18,6 +18,8 @@ namespace sparkle
 		Light(LightType _type = LightType::SpotLight)
 		{
 			SET_COMPONENT_NAME;
+			// Lights are read by the render pipeline and have no per-frame update
+			threadSafe = true;
 			Global::lights.push_back(this);
 			type = _type;
 		}
@@ -36,11 +38,11 @@ namespace sparkle
 		{
 			if (type == LightType::Point || type == LightType::SpotLight)
 			{
-				return glm::vec4(transform()->position, 1.0);
+				return glm::vec4(transform()->worldPosition(), 1.0);
 			}
 			else
 			{
-				return glm::vec4(transform()->position, 0.0);
+				return glm::vec4(transform()->worldPosition(), 0.0);
 			}
 		}
 
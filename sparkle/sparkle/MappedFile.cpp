@@ -0,0 +1,126 @@
+#include "MappedFile.h"
+
+#include <atomic>
+#include <filesystem>
+
+#include <fmt/core.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace sparkle
+{
+#ifdef _WIN32
+	MappedFile::MappedFile(const std::string& path)
+	{
+		HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			return;
+		}
+		m_file = file;
+
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+		{
+			return;
+		}
+
+		HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (mapping == NULL)
+		{
+			return;
+		}
+		m_mapping = mapping;
+
+		m_data = static_cast<const unsigned char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+		if (m_data)
+		{
+			m_size = static_cast<size_t>(size.QuadPart);
+		}
+	}
+
+	MappedFile::~MappedFile()
+	{
+		if (m_data)
+		{
+			UnmapViewOfFile(m_data);
+		}
+		if (m_mapping)
+		{
+			CloseHandle(m_mapping);
+		}
+		if (m_file)
+		{
+			CloseHandle(m_file);
+		}
+	}
+#else
+	MappedFile::MappedFile(const std::string& path)
+	{
+		m_file = open(path.c_str(), O_RDONLY);
+		if (m_file < 0)
+		{
+			return;
+		}
+
+		struct stat info;
+		if (fstat(m_file, &info) != 0 || info.st_size == 0)
+		{
+			return;
+		}
+
+		void* data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, m_file, 0);
+		if (data == MAP_FAILED)
+		{
+			return;
+		}
+		m_data = static_cast<const unsigned char*>(data);
+		m_size = static_cast<size_t>(info.st_size);
+	}
+
+	MappedFile::~MappedFile()
+	{
+		if (m_data)
+		{
+			munmap(const_cast<unsigned char*>(m_data), m_size);
+		}
+		if (m_file >= 0)
+		{
+			close(m_file);
+		}
+	}
+#endif
+
+	std::string MappedFile::TempPath(const std::string& path)
+	{
+		// The process id tells concurrent runs apart, the counter concurrent writes within this one
+		static std::atomic<unsigned int> s_counter{ 0 };
+#ifdef _WIN32
+		const unsigned long processId = GetCurrentProcessId();
+#else
+		const unsigned long processId = static_cast<unsigned long>(getpid());
+#endif
+		return fmt::format("{}.{}-{}.tmp", path, processId, s_counter++);
+	}
+
+	std::error_code MappedFile::Replace(const std::string& tempPath, const std::string& path)
+	{
+		std::error_code error;
+		std::filesystem::rename(tempPath, path, error);
+		if (error)
+		{
+			std::error_code ignored;
+			std::filesystem::remove(tempPath, ignored);
+		}
+		return error;
+	}
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+#include <system_error>
+
+namespace sparkle
+{
+	// Read-only memory mapping of a whole file. The mapping stays valid for the lifetime of the object.
+	class MappedFile
+	{
+	public:
+		MappedFile(const std::string& path);
+		MappedFile(const MappedFile&) = delete;
+		~MappedFile();
+
+		bool valid() const
+		{
+			return m_data != nullptr;
+		}
+
+		const unsigned char* data() const
+		{
+			return m_data;
+		}
+
+		size_t size() const
+		{
+			return m_size;
+		}
+
+		/// <summary>
+		/// Returns a path next to path that no other thread or process writes to, for writing a file in full before
+		/// moving it into place with Replace(); readers never see it half written.
+		/// </summary>
+		static std::string TempPath(const std::string& path);
+
+		/// <summary>
+		/// Moves tempPath over path, and removes tempPath if that fails. On Windows the move fails while any process
+		/// has path mapped, in which case path keeps its previous contents.
+		/// </summary>
+		static std::error_code Replace(const std::string& tempPath, const std::string& path);
+
+	private:
+		const unsigned char* m_data = nullptr;
+		size_t m_size = 0;
+#ifdef _WIN32
+		void* m_file = nullptr;
+		void* m_mapping = nullptr;
+#else
+		int m_file = -1;
+#endif
+	};
+}
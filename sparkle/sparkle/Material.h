@@ -12,6 +12,8 @@
 #include <fmt/core.h>
 #include <glm.hpp>
 
+#include "Global.h"
+
 namespace sparkle
 {
 	class Material
@@ -86,6 +88,7 @@ namespace sparkle
 		void Use() const
 		{
 			glUseProgram(m_shaderID);
+			Global::frameStats.stateChanges++;
 		}
 
 		GLint GetLocation(const std::string& name) const
@@ -0,0 +1,304 @@
+#include "MeshCooker.h"
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <filesystem>
+
+#include <fmt/core.h>
+
+namespace sparkle
+{
+	namespace
+	{
+		const uint32_t k_magic = 0x534d5053; // "SPMS"
+		const uint32_t k_version = 2;
+		const uint64_t k_alignment = 16;
+
+		struct Header
+		{
+			uint32_t magic;
+			uint32_t version;
+			uint32_t importKey;
+			uint32_t numSubmeshes;
+			uint32_t numTextureRefs;
+			uint32_t stringsSize;
+			uint64_t stringsOffset;
+		};
+
+		struct SubmeshEntry
+		{
+			uint32_t numVertices;
+			uint32_t numIndices;
+			uint32_t firstTextureRef;
+			uint32_t numDiffuseMaps;
+			uint32_t numSpecularMaps;
+			uint32_t numLods;
+			uint64_t positionsOffset;
+			uint64_t normalsOffset; // 0 if absent
+			uint64_t texCoordsOffset; // 0 if absent
+			uint64_t indicesOffset; // 0 if absent
+			uint64_t lodsOffset; // 0 if absent
+		};
+
+		struct TextureRef
+		{
+			uint32_t stringOffset;
+			uint32_t length;
+		};
+
+		uint64_t Align(uint64_t offset)
+		{
+			return (offset + k_alignment - 1) & ~(k_alignment - 1);
+		}
+
+		bool InRange(uint64_t offset, uint64_t size, size_t fileSize)
+		{
+			return offset <= fileSize && size <= fileSize - offset;
+		}
+	}
+
+	std::optional<ModelData> MeshCooker::Load(const std::string& sourcePath, unsigned int importKey, const std::string& variant)
+	{
+		namespace fs = std::filesystem;
+
+		const std::string cookedPath = CookedPath(sourcePath, variant);
+		std::error_code error;
+		const auto cookedTime = fs::last_write_time(cookedPath, error);
+		if (error)
+		{
+			return {};
+		}
+		const auto sourceTime = fs::last_write_time(sourcePath, error);
+		if (error || cookedTime < sourceTime)
+		{
+			return {};
+		}
+
+		auto mapping = std::make_shared<MappedFile>(cookedPath);
+		if (!mapping->valid() || mapping->size() < sizeof(Header))
+		{
+			return {};
+		}
+
+		const unsigned char* base = mapping->data();
+		const size_t fileSize = mapping->size();
+
+		Header header;
+		memcpy(&header, base, sizeof(Header));
+		if (header.magic != k_magic || header.version != k_version || header.importKey != importKey)
+		{
+			return {};
+		}
+
+		const uint64_t submeshesOffset = sizeof(Header);
+		const uint64_t textureRefsOffset = submeshesOffset + header.numSubmeshes * sizeof(SubmeshEntry);
+		if (!InRange(submeshesOffset, header.numSubmeshes * sizeof(SubmeshEntry), fileSize) ||
+			!InRange(textureRefsOffset, header.numTextureRefs * sizeof(TextureRef), fileSize) ||
+			!InRange(header.stringsOffset, header.stringsSize, fileSize))
+		{
+			fmt::print("Warning(MeshCooker): Ignoring corrupted cooked mesh({})\n", cookedPath);
+			return {};
+		}
+
+		const auto* submeshes = reinterpret_cast<const SubmeshEntry*>(base + submeshesOffset);
+		const auto* textureRefs = reinterpret_cast<const TextureRef*>(base + textureRefsOffset);
+		const char* strings = reinterpret_cast<const char*>(base + header.stringsOffset);
+
+		auto textureName = [&](uint32_t index) -> std::optional<std::string> {
+			if (index >= header.numTextureRefs)
+			{
+				return {};
+			}
+			const TextureRef& ref = textureRefs[index];
+			if (!InRange(ref.stringOffset, ref.length, header.stringsSize))
+			{
+				return {};
+			}
+			return std::string(strings + ref.stringOffset, ref.length);
+		};
+
+		ModelData result;
+		result.mapping = mapping;
+		result.submeshes.resize(header.numSubmeshes);
+		for (uint32_t i = 0; i < header.numSubmeshes; i++)
+		{
+			const SubmeshEntry& entry = submeshes[i];
+			const uint64_t vec3Size = uint64_t(entry.numVertices) * sizeof(glm::vec3);
+			const uint64_t vec2Size = uint64_t(entry.numVertices) * sizeof(glm::vec2);
+			const uint64_t indexSize = uint64_t(entry.numIndices) * sizeof(unsigned int);
+			const uint64_t lodsSize = uint64_t(entry.numLods) * sizeof(MeshLod);
+			if (!InRange(entry.positionsOffset, vec3Size, fileSize) ||
+				(entry.normalsOffset && !InRange(entry.normalsOffset, vec3Size, fileSize)) ||
+				(entry.texCoordsOffset && !InRange(entry.texCoordsOffset, vec2Size, fileSize)) ||
+				(entry.indicesOffset && !InRange(entry.indicesOffset, indexSize, fileSize)) ||
+				(entry.lodsOffset && !InRange(entry.lodsOffset, lodsSize, fileSize)))
+			{
+				fmt::print("Warning(MeshCooker): Ignoring corrupted cooked mesh({})\n", cookedPath);
+				return {};
+			}
+
+			const MeshLod* lods = entry.lodsOffset ? reinterpret_cast<const MeshLod*>(base + entry.lodsOffset) : nullptr;
+			for (uint32_t l = 0; lods && l < entry.numLods; l++)
+			{
+				if (!InRange(lods[l].firstIndex, lods[l].numIndices, entry.numIndices))
+				{
+					fmt::print("Warning(MeshCooker): Ignoring corrupted cooked mesh({})\n", cookedPath);
+					return {};
+				}
+			}
+
+			MeshView view;
+			view.numVertices = entry.numVertices;
+			view.numIndices = entry.indicesOffset ? entry.numIndices : 0;
+			view.positions = reinterpret_cast<const glm::vec3*>(base + entry.positionsOffset);
+			view.normals = entry.normalsOffset ? reinterpret_cast<const glm::vec3*>(base + entry.normalsOffset) : nullptr;
+			view.texCoords = entry.texCoordsOffset ? reinterpret_cast<const glm::vec2*>(base + entry.texCoordsOffset) : nullptr;
+			view.indices = entry.indicesOffset ? reinterpret_cast<const unsigned int*>(base + entry.indicesOffset) : nullptr;
+			view.lods = lods;
+			view.numLods = lods ? entry.numLods : 0;
+
+			SubmeshData& submesh = result.submeshes[i];
+			submesh.cooked = view;
+			for (uint32_t t = 0; t < entry.numDiffuseMaps + entry.numSpecularMaps; t++)
+			{
+				auto name = textureName(entry.firstTextureRef + t);
+				if (!name.has_value())
+				{
+					fmt::print("Warning(MeshCooker): Ignoring corrupted cooked mesh({})\n", cookedPath);
+					return {};
+				}
+				auto& maps = (t < entry.numDiffuseMaps) ? submesh.diffuseMaps : submesh.specularMaps;
+				maps.push_back(*name);
+			}
+		}
+		return result;
+	}
+
+	bool MeshCooker::Cook(const std::string& sourcePath, unsigned int importKey, const ModelData& data, const std::string& variant)
+	{
+		Header header{};
+		header.magic = k_magic;
+		header.version = k_version;
+		header.importKey = importKey;
+		header.numSubmeshes = static_cast<uint32_t>(data.submeshes.size());
+
+		std::vector<SubmeshEntry> entries(data.submeshes.size());
+		std::vector<TextureRef> textureRefs;
+		std::string strings;
+
+		for (size_t i = 0; i < data.submeshes.size(); i++)
+		{
+			const SubmeshData& submesh = data.submeshes[i];
+			SubmeshEntry& entry = entries[i];
+			entry.firstTextureRef = static_cast<uint32_t>(textureRefs.size());
+			entry.numDiffuseMaps = static_cast<uint32_t>(submesh.diffuseMaps.size());
+			entry.numSpecularMaps = static_cast<uint32_t>(submesh.specularMaps.size());
+			for (const auto* maps : { &submesh.diffuseMaps, &submesh.specularMaps })
+			{
+				for (const auto& name : *maps)
+				{
+					textureRefs.push_back({ static_cast<uint32_t>(strings.size()), static_cast<uint32_t>(name.size()) });
+					strings += name;
+				}
+			}
+		}
+		header.numTextureRefs = static_cast<uint32_t>(textureRefs.size());
+		header.stringsSize = static_cast<uint32_t>(strings.size());
+		header.stringsOffset = sizeof(Header) + entries.size() * sizeof(SubmeshEntry) + textureRefs.size() * sizeof(TextureRef);
+
+		// Assign blob offsets
+		uint64_t offset = Align(header.stringsOffset + strings.size());
+		auto allocate = [&offset](uint64_t size) {
+			uint64_t result = offset;
+			offset = Align(offset + size);
+			return result;
+		};
+		for (size_t i = 0; i < data.submeshes.size(); i++)
+		{
+			const MeshView view = data.submeshes[i].view();
+			SubmeshEntry& entry = entries[i];
+			entry.numVertices = view.numVertices;
+			entry.numIndices = view.numIndices;
+			entry.positionsOffset = allocate(uint64_t(view.numVertices) * sizeof(glm::vec3));
+			entry.normalsOffset = view.normals ? allocate(uint64_t(view.numVertices) * sizeof(glm::vec3)) : 0;
+			entry.texCoordsOffset = view.texCoords ? allocate(uint64_t(view.numVertices) * sizeof(glm::vec2)) : 0;
+			entry.indicesOffset = view.indices ? allocate(uint64_t(view.numIndices) * sizeof(unsigned int)) : 0;
+			entry.numLods = view.numLods;
+			entry.lodsOffset = view.lods ? allocate(uint64_t(view.numLods) * sizeof(MeshLod)) : 0;
+		}
+
+		const std::string cookedPath = CookedPath(sourcePath, variant);
+		const std::string tempPath = MappedFile::TempPath(cookedPath);
+		{
+			std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+			if (!file)
+			{
+				fmt::print("Warning(MeshCooker): Failed to write cooked mesh({})\n", cookedPath);
+				return false;
+			}
+
+			uint64_t written = 0;
+			auto write = [&file, &written](const void* bytes, uint64_t size) {
+				file.write(static_cast<const char*>(bytes), static_cast<std::streamsize>(size));
+				written += size;
+			};
+			auto seek = [&file, &written](uint64_t target) {
+				static const char zeros[k_alignment] = {};
+				file.write(zeros, static_cast<std::streamsize>(target - written));
+				written = target;
+			};
+
+			write(&header, sizeof(Header));
+			write(entries.data(), entries.size() * sizeof(SubmeshEntry));
+			write(textureRefs.data(), textureRefs.size() * sizeof(TextureRef));
+			write(strings.data(), strings.size());
+			for (size_t i = 0; i < data.submeshes.size(); i++)
+			{
+				const MeshView view = data.submeshes[i].view();
+				const SubmeshEntry& entry = entries[i];
+				seek(entry.positionsOffset);
+				write(view.positions, uint64_t(view.numVertices) * sizeof(glm::vec3));
+				if (entry.normalsOffset)
+				{
+					seek(entry.normalsOffset);
+					write(view.normals, uint64_t(view.numVertices) * sizeof(glm::vec3));
+				}
+				if (entry.texCoordsOffset)
+				{
+					seek(entry.texCoordsOffset);
+					write(view.texCoords, uint64_t(view.numVertices) * sizeof(glm::vec2));
+				}
+				if (entry.indicesOffset)
+				{
+					seek(entry.indicesOffset);
+					write(view.indices, uint64_t(view.numIndices) * sizeof(unsigned int));
+				}
+				if (entry.lodsOffset)
+				{
+					seek(entry.lodsOffset);
+					write(view.lods, uint64_t(view.numLods) * sizeof(MeshLod));
+				}
+			}
+
+			if (!file)
+			{
+				fmt::print("Warning(MeshCooker): Failed to write cooked mesh({})\n", cookedPath);
+				file.close();
+				std::error_code error;
+				std::filesystem::remove(tempPath, error);
+				return false;
+			}
+		}
+
+		// On Windows this fails while the cooked file is mapped, e.g. by another run loading it. The existing file then
+		// stays; if it is stale, the next load finds it older than the source and cooks again.
+		const std::error_code error = MappedFile::Replace(tempPath, cookedPath);
+		if (error)
+		{
+			fmt::print("Warning(MeshCooker): Cannot replace cooked mesh({}), keeping the existing one: {}\n", cookedPath, error.message());
+			return false;
+		}
+		return true;
+	}
+}
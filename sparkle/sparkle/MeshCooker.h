@@ -0,0 +1,40 @@
+#pragma once
+
+#include <string>
+#include <optional>
+
+#include "Model.h"
+
+namespace sparkle
+{
+	// Reads and writes "cooked" meshes: a binary copy of an imported model which is memory-mapped
+	// and uploaded as-is on later loads, skipping Assimp entirely.
+	//
+	// File layout (little endian, blobs aligned to 16 bytes):
+	//   Header | Submesh table | Texture reference table | String blob | vertex/index blobs
+	// Each submesh references its positions, normals, texCoords, indices and LOD table blobs by file offset,
+	// and its diffuse/specular textures by a range in the texture reference table.
+	class MeshCooker
+	{
+	public:
+		/// <summary>
+		/// Maps the cooked file of sourcePath if it exists, is at least as new as sourcePath,
+		/// and was cooked with the same importKey (e.g. the Assimp post-processing flags).
+		/// </summary>
+		/// <param name="variant">Tells apart different imports of one source, which each get their own cooked file</param>
+		/// <returns>An empty optional if there is no usable cooked file</returns>
+		static std::optional<ModelData> Load(const std::string& sourcePath, unsigned int importKey, const std::string& variant = "");
+
+		/// <summary>
+		/// Writes data as the cooked file of sourcePath. The file is written under a temporary name and
+		/// then renamed, so concurrent readers never observe a partial file.
+		/// </summary>
+		/// <returns>False if the file could not be written</returns>
+		static bool Cook(const std::string& sourcePath, unsigned int importKey, const ModelData& data, const std::string& variant = "");
+
+		static std::string CookedPath(const std::string& sourcePath, const std::string& variant = "")
+		{
+			return sourcePath + variant + ".spmesh";
+		}
+	};
+}
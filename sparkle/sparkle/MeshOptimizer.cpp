@@ -0,0 +1,396 @@
+#include "MeshOptimizer.h"
+
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <algorithm>
+#include <unordered_map>
+
+namespace sparkle
+{
+	namespace
+	{
+		struct VertexKey
+		{
+			glm::vec3 position;
+			glm::vec3 normal;
+			glm::vec2 texCoord;
+
+			bool operator==(const VertexKey& other) const
+			{
+				return memcmp(this, &other, sizeof(VertexKey)) == 0;
+			}
+		};
+
+		struct VertexKeyHash
+		{
+			size_t operator()(const VertexKey& key) const
+			{
+				// FNV-1a over the raw attribute bits
+				const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&key);
+				uint64_t hash = 14695981039346656037ull;
+				for (size_t i = 0; i < sizeof(VertexKey); i++)
+				{
+					hash = (hash ^ bytes[i]) * 1099511628211ull;
+				}
+				return static_cast<size_t>(hash);
+			}
+		};
+
+		// Forsyth's scoring: vertices recently used score high (except the last triangle's, which would
+		// be re-hit anyway), and vertices with few remaining triangles are boosted so they finish early.
+		float VertexScore(int cachePosition, unsigned int remainingTriangles)
+		{
+			if (remainingTriangles == 0)
+			{
+				return -1.0f;
+			}
+
+			float score = 0.0f;
+			if (cachePosition >= 0)
+			{
+				if (cachePosition < 3)
+				{
+					score = 0.75f;
+				}
+				else
+				{
+					const float scale = 1.0f / (MeshOptimizer::k_cacheSize - 3);
+					score = std::pow(1.0f - (cachePosition - 3) * scale, 1.5f);
+				}
+			}
+			return score + 2.0f / std::sqrt(static_cast<float>(remainingTriangles));
+		}
+
+		template <class T>
+		void Remap(std::vector<T>& attribute, const std::vector<unsigned int>& newToOld)
+		{
+			if (attribute.empty())
+			{
+				return;
+			}
+
+			std::vector<T> result(newToOld.size());
+			for (size_t i = 0; i < newToOld.size(); i++)
+			{
+				result[i] = attribute[newToOld[i]];
+			}
+			attribute = std::move(result);
+		}
+	}
+
+	MeshOptimizer::Stats MeshOptimizer::Optimize(MeshData& mesh)
+	{
+		Stats stats;
+		stats.numTriangles = mesh.indices.size() / 3;
+		stats.verticesBefore = mesh.positions.size();
+		stats.acmrBefore = ComputeACMR(mesh.indices, mesh.positions.size());
+
+		// Meshes with LODs are left alone, as their index ranges would no longer match
+		if (!mesh.indices.empty() && mesh.indices.size() % 3 == 0 && mesh.lods.empty())
+		{
+			std::vector<size_t> clusterStarts;
+			WeldVertices(mesh);
+			OptimizeVertexCache(mesh.indices, mesh.positions.size(), &clusterStarts);
+			OptimizeOverdraw(mesh, clusterStarts);
+			OptimizeVertexFetch(mesh);
+		}
+
+		stats.verticesAfter = mesh.positions.size();
+		stats.acmrAfter = ComputeACMR(mesh.indices, mesh.positions.size());
+		return stats;
+	}
+
+	void MeshOptimizer::WeldVertices(MeshData& mesh)
+	{
+		const size_t numVertices = mesh.positions.size();
+		const bool hasNormals = mesh.normals.size() == numVertices;
+		const bool hasTexCoords = mesh.texCoords.size() == numVertices;
+
+		std::unordered_map<VertexKey, unsigned int, VertexKeyHash> unique;
+		unique.reserve(numVertices);
+		std::vector<unsigned int> oldToNew(numVertices);
+		std::vector<unsigned int> newToOld;
+		newToOld.reserve(numVertices);
+
+		for (size_t i = 0; i < numVertices; i++)
+		{
+			VertexKey key;
+			memset(&key, 0, sizeof(VertexKey));
+			key.position = mesh.positions[i];
+			key.normal = hasNormals ? mesh.normals[i] : glm::vec3(0.0f);
+			key.texCoord = hasTexCoords ? mesh.texCoords[i] : glm::vec2(0.0f);
+
+			auto [it, inserted] = unique.emplace(key, static_cast<unsigned int>(newToOld.size()));
+			if (inserted)
+			{
+				newToOld.push_back(static_cast<unsigned int>(i));
+			}
+			oldToNew[i] = it->second;
+		}
+
+		if (newToOld.size() == numVertices)
+		{
+			return;
+		}
+
+		for (auto& index : mesh.indices)
+		{
+			index = oldToNew[index];
+		}
+		Remap(mesh.positions, newToOld);
+		Remap(mesh.normals, newToOld);
+		Remap(mesh.texCoords, newToOld);
+	}
+
+	void MeshOptimizer::OptimizeVertexCache(std::vector<unsigned int>& indices, size_t numVertices, std::vector<size_t>* clusterStarts)
+	{
+		const size_t numTriangles = indices.size() / 3;
+		if (numTriangles == 0)
+		{
+			return;
+		}
+
+		// Triangles adjacent to each vertex; the first remaining[v] entries of a vertex are the ones not yet emitted.
+		std::vector<unsigned int> remaining(numVertices, 0);
+		for (auto index : indices)
+		{
+			remaining[index]++;
+		}
+		std::vector<size_t> adjacencyOffsets(numVertices + 1, 0);
+		for (size_t v = 0; v < numVertices; v++)
+		{
+			adjacencyOffsets[v + 1] = adjacencyOffsets[v] + remaining[v];
+		}
+		std::vector<unsigned int> adjacency(indices.size());
+		{
+			std::vector<size_t> cursor(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+			for (size_t i = 0; i < indices.size(); i++)
+			{
+				adjacency[cursor[indices[i]]++] = static_cast<unsigned int>(i / 3);
+			}
+		}
+
+		std::vector<int> cachePosition(numVertices, -1);
+		std::vector<float> vertexScore(numVertices);
+		for (size_t v = 0; v < numVertices; v++)
+		{
+			vertexScore[v] = VertexScore(-1, remaining[v]);
+		}
+
+		std::vector<float> triangleScore(numTriangles, 0.0f);
+		std::vector<bool> emitted(numTriangles, false);
+		for (size_t i = 0; i < indices.size(); i++)
+		{
+			triangleScore[i / 3] += vertexScore[indices[i]];
+		}
+
+		std::vector<unsigned int> result;
+		result.reserve(indices.size());
+		std::vector<unsigned int> cache;
+		std::vector<unsigned int> nextCache;
+		cache.reserve(k_cacheSize + 3);
+		nextCache.reserve(k_cacheSize + 3);
+
+		long long best = std::max_element(triangleScore.begin(), triangleScore.end()) - triangleScore.begin();
+		size_t scanCursor = 0;
+		if (clusterStarts)
+		{
+			clusterStarts->clear();
+		}
+
+		while (result.size() < indices.size())
+		{
+			if (best < 0)
+			{
+				// Nothing adjacent to the cache is left; continue with the next triangle in input order.
+				while (emitted[scanCursor])
+				{
+					scanCursor++;
+				}
+				best = static_cast<long long>(scanCursor);
+				if (clusterStarts)
+				{
+					clusterStarts->push_back(result.size() / 3);
+				}
+			}
+			else if (result.empty() && clusterStarts)
+			{
+				clusterStarts->push_back(0);
+			}
+
+			const unsigned int* triangle = &indices[best * 3];
+			emitted[best] = true;
+			for (int corner = 0; corner < 3; corner++)
+			{
+				const unsigned int v = triangle[corner];
+				result.push_back(v);
+
+				unsigned int* begin = &adjacency[adjacencyOffsets[v]];
+				unsigned int* end = begin + remaining[v];
+				std::iter_swap(std::find(begin, end, static_cast<unsigned int>(best)), end - 1);
+				remaining[v]--;
+			}
+
+			// LRU update: the triangle's vertices move to the front
+			nextCache.assign(triangle, triangle + 3);
+			for (auto v : cache)
+			{
+				if (v != triangle[0] && v != triangle[1] && v != triangle[2])
+				{
+					nextCache.push_back(v);
+				}
+			}
+			for (size_t i = 0; i < nextCache.size(); i++)
+			{
+				cachePosition[nextCache[i]] = (i < k_cacheSize) ? static_cast<int>(i) : -1;
+			}
+
+			// Rescore everything that was or is in the cache, including vertices which just dropped out
+			for (auto v : nextCache)
+			{
+				const float score = VertexScore(cachePosition[v], remaining[v]);
+				const float delta = score - vertexScore[v];
+				vertexScore[v] = score;
+				for (size_t i = adjacencyOffsets[v]; i < adjacencyOffsets[v] + remaining[v]; i++)
+				{
+					triangleScore[adjacency[i]] += delta;
+				}
+			}
+
+			if (nextCache.size() > k_cacheSize)
+			{
+				nextCache.resize(k_cacheSize);
+			}
+			std::swap(cache, nextCache);
+
+			best = -1;
+			float bestScore = -1.0f;
+			for (auto v : cache)
+			{
+				for (size_t i = adjacencyOffsets[v]; i < adjacencyOffsets[v] + remaining[v]; i++)
+				{
+					if (triangleScore[adjacency[i]] > bestScore)
+					{
+						bestScore = triangleScore[adjacency[i]];
+						best = adjacency[i];
+					}
+				}
+			}
+		}
+
+		indices = std::move(result);
+	}
+
+	void MeshOptimizer::OptimizeOverdraw(MeshData& mesh, const std::vector<size_t>& clusterStarts)
+	{
+		const size_t numTriangles = mesh.indices.size() / 3;
+		if (clusterStarts.size() < 2)
+		{
+			return;
+		}
+
+		// Area-weighted centroid and normal of every cluster
+		struct Cluster
+		{
+			size_t begin;
+			size_t end;
+			glm::vec3 centroid = glm::vec3(0.0f);
+			glm::vec3 normal = glm::vec3(0.0f);
+			float sortKey = 0.0f;
+		};
+		std::vector<Cluster> clusters;
+		glm::vec3 meshCentroid(0.0f);
+		float meshArea = 0.0f;
+
+		for (size_t c = 0; c < clusterStarts.size(); c++)
+		{
+			Cluster cluster;
+			cluster.begin = clusterStarts[c];
+			cluster.end = (c + 1 < clusterStarts.size()) ? clusterStarts[c + 1] : numTriangles;
+
+			float area = 0.0f;
+			for (size_t t = cluster.begin; t < cluster.end; t++)
+			{
+				const glm::vec3& p0 = mesh.positions[mesh.indices[t * 3]];
+				const glm::vec3& p1 = mesh.positions[mesh.indices[t * 3 + 1]];
+				const glm::vec3& p2 = mesh.positions[mesh.indices[t * 3 + 2]];
+				const glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+				const float triangleArea = glm::length(n);
+				cluster.centroid += (p0 + p1 + p2) * (triangleArea / 3.0f);
+				cluster.normal += n;
+				area += triangleArea;
+			}
+			meshCentroid += cluster.centroid;
+			meshArea += area;
+			if (area > 0.0f)
+			{
+				cluster.centroid /= area;
+			}
+			clusters.push_back(cluster);
+		}
+		if (meshArea > 0.0f)
+		{
+			meshCentroid /= meshArea;
+		}
+
+		// Clusters facing away from the center are likely in front of the others: draw them first
+		for (auto& cluster : clusters)
+		{
+			const float length = glm::length(cluster.normal);
+			cluster.sortKey = (length > 0.0f) ? glm::dot(cluster.centroid - meshCentroid, cluster.normal / length) : 0.0f;
+		}
+		std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& a, const Cluster& b) { return a.sortKey > b.sortKey; });
+
+		std::vector<unsigned int> result;
+		result.reserve(mesh.indices.size());
+		for (const auto& cluster : clusters)
+		{
+			result.insert(result.end(), mesh.indices.begin() + cluster.begin * 3, mesh.indices.begin() + cluster.end * 3);
+		}
+		mesh.indices = std::move(result);
+	}
+
+	void MeshOptimizer::OptimizeVertexFetch(MeshData& mesh)
+	{
+		const unsigned int k_unused = ~0u;
+		std::vector<unsigned int> oldToNew(mesh.positions.size(), k_unused);
+		std::vector<unsigned int> newToOld;
+		newToOld.reserve(mesh.positions.size());
+
+		for (auto& index : mesh.indices)
+		{
+			if (oldToNew[index] == k_unused)
+			{
+				oldToNew[index] = static_cast<unsigned int>(newToOld.size());
+				newToOld.push_back(index);
+			}
+			index = oldToNew[index];
+		}
+
+		Remap(mesh.positions, newToOld);
+		Remap(mesh.normals, newToOld);
+		Remap(mesh.texCoords, newToOld);
+	}
+
+	float MeshOptimizer::ComputeACMR(const std::vector<unsigned int>& indices, size_t numVertices, unsigned int cacheSize)
+	{
+		if (indices.size() < 3)
+		{
+			return 0.0f;
+		}
+
+		// FIFO cache, as in most hardware; timestamps avoid searching the cache.
+		std::vector<size_t> insertedAt(numVertices, 0);
+		size_t misses = 0;
+		for (auto index : indices)
+		{
+			if (insertedAt[index] == 0 || misses - insertedAt[index] + 1 > cacheSize)
+			{
+				misses++;
+				insertedAt[index] = misses;
+			}
+		}
+		return static_cast<float>(misses) / (indices.size() / 3);
+	}
+}
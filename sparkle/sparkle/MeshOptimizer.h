@@ -0,0 +1,58 @@
+#pragma once
+
+#include <vector>
+
+#include "Model.h"
+
+namespace sparkle
+{
+	// Reorders imported meshes for the GPU, without changing what they look like:
+	//   1. Welds vertices with identical attributes (Assimp emits one vertex per face corner).
+	//   2. Reorders triangles for the post-transform vertex cache (Forsyth's linear-speed algorithm).
+	//   3. Sorts the resulting triangle clusters so that outward-facing ones draw first, reducing overdraw.
+	//   4. Reorders vertices in order of first use, for vertex fetch locality.
+	// Cache efficiency is measured as ACMR: transformed vertices per triangle for a FIFO cache (3 worst, ~0.5 best).
+	class MeshOptimizer
+	{
+	public:
+		// Post-transform cache size used for both optimizing and measuring.
+		static const unsigned int k_cacheSize = 32;
+
+		struct Stats
+		{
+			size_t numTriangles = 0;
+			size_t verticesBefore = 0;
+			size_t verticesAfter = 0;
+			float acmrBefore = 0.0f;
+			float acmrAfter = 0.0f;
+		};
+
+		/// <summary>
+		/// Runs all passes on mesh. Meshes without a triangle list index buffer, or which already have LODs, are left untouched.
+		/// </summary>
+		static Stats Optimize(MeshData& mesh);
+
+		/// <summary>
+		/// Merges vertices whose position, normal and texCoord are bitwise identical and remaps the indices.
+		/// </summary>
+		static void WeldVertices(MeshData& mesh);
+
+		/// <summary>
+		/// Reorders triangles for vertex cache locality.
+		/// </summary>
+		/// <param name="clusterStarts">If given, receives the first triangle of each run of triangles that starts from a cold cache</param>
+		static void OptimizeVertexCache(std::vector<unsigned int>& indices, size_t numVertices, std::vector<size_t>* clusterStarts = nullptr);
+
+		/// <summary>
+		/// Reorders the clusters from OptimizeVertexCache(), keeping the triangle order inside each cluster.
+		/// </summary>
+		static void OptimizeOverdraw(MeshData& mesh, const std::vector<size_t>& clusterStarts);
+
+		/// <summary>
+		/// Reorders vertices in order of first use by the index buffer and drops unreferenced vertices.
+		/// </summary>
+		static void OptimizeVertexFetch(MeshData& mesh);
+
+		static float ComputeACMR(const std::vector<unsigned int>& indices, size_t numVertices, unsigned int cacheSize = k_cacheSize);
+	};
+}
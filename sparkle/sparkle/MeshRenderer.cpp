@@ -15,6 +15,8 @@ namespace sparkle
 	) : m_mesh(mesh), m_material(material)
 	{
 		SET_COMPONENT_NAME;
+		// Renderers only draw, from the render pipeline on the main thread; their updates don't do anything
+		threadSafe = true;
 
 		if (castShadow)
 		{
@@ -36,7 +38,7 @@ namespace sparkle
 		}
 		const auto light = Global::lights[0];
 		const std::string& prefix = fmt::format("spotLight.");
-		const auto front = utils::RotateEuler(glm::vec3(0, -1, 0), light->transform()->rotation);
+		const auto front = glm::normalize(glm::mat3(light->transform()->matrix()) * glm::vec3(0, -1, 0));
 
 		m_material->SetVec3(prefix + "position", light->position());
 		m_material->SetVec3(prefix + "direction", front);
@@ -72,7 +74,7 @@ namespace sparkle
 		}
 
 		// Camera param
-		m_material->SetVec3("_CameraPos", Global::camera->transform()->position);
+		m_material->SetVec3("_CameraPos", Global::camera->position());
 
 		// Light params
 		SetupLighting(m_material);
@@ -83,14 +85,15 @@ namespace sparkle
 		{
 			glActiveTexture(GL_TEXTURE0 + i);
 			glBindTexture(GL_TEXTURE_2D, tex.second);
+			Global::frameStats.stateChanges++;
 			m_material->SetInt(tex.first, i);
 			i++;
 		}
 
 		// matrices
-		auto model = actor->transform->matrix();
-		auto view = Global::camera->view();
-		auto projection = Global::camera->projection();
+		const auto model = actor->transform->matrix();
+		const auto view = Global::camera->view();
+		const auto projection = Global::camera->projection();
 
 		m_material->SetMat4("_Model", model);
 		m_material->SetMat4("_View", view);
@@ -100,13 +103,13 @@ namespace sparkle
 		// If this shader does not have this uniform, it will be ignored.
 		// Note that most shaders will need to do lighting, and thus need the individual m/v/p matrices.
 		// But some shaders don't, so they can accept a combined matrix for a performance boost.
-		m_material->SetMat4("_MVP", projection * view * model);
-		m_material->SetMat4("_InvView", glm::inverse(view));
-		m_material->SetMat3("_NormalMatrix", glm::transpose(glm::inverse(model)));
+		m_material->SetMat4("_MVP", Global::camera->viewProjection() * model);
+		m_material->SetMat4("_InvView", Global::camera->inverseView());
+		m_material->SetMat3("_NormalMatrix", actor->transform->normalMatrix());
 
 		m_material->SetMat4("_WorldToLight", lightMatrix);
 
-		DrawCall();
+		DrawCall(m_lod);
 	}
 
 	void MeshRenderer::RenderShadow(glm::mat4 lightMatrix)
@@ -120,29 +123,39 @@ namespace sparkle
 		m_shadowMaterial->SetMat4("_Model", actor->transform->matrix());
 		m_shadowMaterial->SetMat4("_WorldToLight", lightMatrix);
 
-		DrawCall();
+		// Shadow maps are low resolution and filtered, so coarser geometry goes unnoticed
+		DrawCall(m_lod + Global::Config::shadowLodBias);
 	}
 
-	void MeshRenderer::DrawCall()
+	void MeshRenderer::DrawCall(unsigned int lod)
 	{
+		auto& stats = Global::frameStats;
 		if (m_material->doubleSided)
 		{
 			glDisable(GL_CULL_FACE);
+			stats.stateChanges += 2;
 		}
 
 		glBindVertexArray(m_mesh->VAO());
+		stats.stateChanges++;
+		stats.drawCalls++;
+		const unsigned int numInstances = static_cast<unsigned int>(std::max(m_numInstances, 1));
 		if (m_mesh->useIndices())
 		{
+			const MeshLod& range = m_mesh->lod(std::min(lod, m_mesh->numLods() - 1));
+			stats.triangles += range.numIndices / 3 * numInstances;
+			const void* offset = (const void*)(range.firstIndex * sizeof(unsigned int));
 			if (m_numInstances > 0)
 			{
-				glDrawElementsInstanced(GL_TRIANGLES, m_mesh->drawCount(), GL_UNSIGNED_INT, 0, m_numInstances);
+				glDrawElementsInstanced(GL_TRIANGLES, range.numIndices, GL_UNSIGNED_INT, offset, m_numInstances);
 			}
 			else {
-				glDrawElements(GL_TRIANGLES, m_mesh->drawCount(), GL_UNSIGNED_INT, 0);
+				glDrawElements(GL_TRIANGLES, range.numIndices, GL_UNSIGNED_INT, offset);
 			}
 		}
 		else
 		{
+			stats.triangles += m_mesh->drawCount() / 3 * numInstances;
 			if (m_numInstances > 0)
 			{
 				glDrawArraysInstanced(GL_TRIANGLES, 0, m_mesh->drawCount(), m_numInstances);
@@ -24,7 +24,7 @@ namespace sparkle
 
 		virtual void RenderShadow(glm::mat4 lightMatrix);
 
-		virtual void DrawCall();
+		virtual void DrawCall(unsigned int lod = 0);
 
 		std::shared_ptr<Material> material() const;
 
@@ -32,11 +32,23 @@ namespace sparkle
 		{
 			return m_mesh;
 		}
+
+		// Level of detail of the mesh to render, chosen by RenderPipeline each frame
+		unsigned int lod() const
+		{
+			return m_lod;
+		}
+
+		void SetLod(unsigned int lod)
+		{
+			m_lod = lod;
+		}
 		
 	protected:
 		void SetupLighting(std::shared_ptr<Material> material);
 
 		int m_numInstances = 0;
+		unsigned int m_lod = 0;
 		std::shared_ptr<Mesh> m_mesh;
 		std::shared_ptr<Material> m_material;
 		std::shared_ptr<Material> m_shadowMaterial;
@@ -0,0 +1,350 @@
+#include "MeshSimplifier.h"
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <unordered_map>
+
+#include "MeshOptimizer.h"
+
+namespace sparkle
+{
+	namespace
+	{
+		// Symmetric 4x4 matrix of the summed squared distances to a set of planes, weighted by triangle area.
+		struct Quadric
+		{
+			double a00 = 0, a01 = 0, a02 = 0, a03 = 0;
+			double a11 = 0, a12 = 0, a13 = 0;
+			double a22 = 0, a23 = 0;
+			double a33 = 0;
+			double weight = 0;
+
+			void AddPlane(const glm::dvec3& n, double d, double w)
+			{
+				a00 += w * n.x * n.x; a01 += w * n.x * n.y; a02 += w * n.x * n.z; a03 += w * n.x * d;
+				a11 += w * n.y * n.y; a12 += w * n.y * n.z; a13 += w * n.y * d;
+				a22 += w * n.z * n.z; a23 += w * n.z * d;
+				a33 += w * d * d;
+				weight += w;
+			}
+
+			Quadric& operator+=(const Quadric& other)
+			{
+				a00 += other.a00; a01 += other.a01; a02 += other.a02; a03 += other.a03;
+				a11 += other.a11; a12 += other.a12; a13 += other.a13;
+				a22 += other.a22; a23 += other.a23;
+				a33 += other.a33;
+				weight += other.weight;
+				return *this;
+			}
+
+			// Mean squared distance of p to the planes
+			double Evaluate(const glm::dvec3& p) const
+			{
+				const double result =
+					a00 * p.x * p.x + 2 * a01 * p.x * p.y + 2 * a02 * p.x * p.z + 2 * a03 * p.x +
+					a11 * p.y * p.y + 2 * a12 * p.y * p.z + 2 * a13 * p.y +
+					a22 * p.z * p.z + 2 * a23 * p.z +
+					a33;
+				return weight > 0 ? std::max(result, 0.0) / weight : 0.0;
+			}
+		};
+
+		struct Collapse
+		{
+			unsigned int from;
+			unsigned int to;
+			double cost;
+		};
+
+		struct PositionHash
+		{
+			size_t operator()(const glm::vec3& p) const
+			{
+				uint32_t bits[3];
+				memcpy(bits, &p, sizeof(bits));
+				return (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u);
+			}
+		};
+
+		struct PositionEqual
+		{
+			bool operator()(const glm::vec3& a, const glm::vec3& b) const
+			{
+				return memcmp(&a, &b, sizeof(glm::vec3)) == 0;
+			}
+		};
+
+		uint64_t EdgeKey(unsigned int a, unsigned int b)
+		{
+			return (a < b) ? (uint64_t(a) << 32 | b) : (uint64_t(b) << 32 | a);
+		}
+	}
+
+	std::vector<unsigned int> MeshSimplifier::Simplify(const std::vector<glm::vec3>& positions, const std::vector<unsigned int>& indices,
+		size_t targetIndexCount, float& resultError)
+	{
+		resultError = 0.0f;
+		const size_t numVertices = positions.size();
+		std::vector<unsigned int> result = indices;
+		if (result.size() <= targetIndexCount)
+		{
+			return result;
+		}
+
+		// Vertices sharing a position (split by normals or texCoords) are one vertex to the simplifier
+		std::vector<unsigned int> canonical(numVertices);
+		std::vector<unsigned int> numCopies(numVertices, 0);
+		{
+			std::unordered_map<glm::vec3, unsigned int, PositionHash, PositionEqual> unique;
+			unique.reserve(numVertices);
+			for (unsigned int v = 0; v < numVertices; v++)
+			{
+				canonical[v] = unique.emplace(positions[v], v).first->second;
+			}
+			std::vector<bool> referenced(numVertices, false);
+			for (auto index : result)
+			{
+				if (!referenced[index])
+				{
+					referenced[index] = true;
+					numCopies[canonical[index]]++;
+				}
+			}
+		}
+
+		// Lock seams, open borders and non-manifold edges
+		std::vector<bool> locked(numVertices, false);
+		{
+			std::unordered_map<uint64_t, unsigned int> edgeCount;
+			edgeCount.reserve(result.size());
+			for (size_t i = 0; i < result.size(); i += 3)
+			{
+				for (int e = 0; e < 3; e++)
+				{
+					edgeCount[EdgeKey(canonical[result[i + e]], canonical[result[i + (e + 1) % 3]])]++;
+				}
+			}
+			for (const auto& [key, count] : edgeCount)
+			{
+				if (count != 2)
+				{
+					locked[key >> 32] = true;
+					locked[key & 0xffffffff] = true;
+				}
+			}
+			for (unsigned int v = 0; v < numVertices; v++)
+			{
+				if (numCopies[canonical[v]] > 1)
+				{
+					locked[canonical[v]] = true;
+				}
+			}
+		}
+
+		std::vector<Quadric> quadrics(numVertices);
+		for (size_t i = 0; i < result.size(); i += 3)
+		{
+			const glm::dvec3 p0 = positions[result[i]];
+			const glm::dvec3 p1 = positions[result[i + 1]];
+			const glm::dvec3 p2 = positions[result[i + 2]];
+			const glm::dvec3 cross = glm::cross(p1 - p0, p2 - p0);
+			const double area = glm::length(cross);
+			if (area <= 0)
+			{
+				continue;
+			}
+			const glm::dvec3 normal = cross / area;
+			for (int corner = 0; corner < 3; corner++)
+			{
+				quadrics[canonical[result[i + corner]]].AddPlane(normal, -glm::dot(normal, p0), area);
+			}
+		}
+
+		double maxError = 0.0;
+		std::vector<Collapse> collapses;
+		std::vector<unsigned int> remap(numVertices);
+		std::vector<bool> touched(numVertices);
+		std::vector<unsigned int> triangleCount(numVertices);
+		std::vector<size_t> adjacencyOffsets(numVertices + 1);
+		std::vector<unsigned int> adjacency;
+
+		while (result.size() > targetIndexCount)
+		{
+			// Vertex to triangle adjacency of the current triangles
+			std::fill(triangleCount.begin(), triangleCount.end(), 0);
+			for (auto index : result)
+			{
+				triangleCount[index]++;
+			}
+			adjacencyOffsets[0] = 0;
+			for (size_t v = 0; v < numVertices; v++)
+			{
+				adjacencyOffsets[v + 1] = adjacencyOffsets[v] + triangleCount[v];
+			}
+			adjacency.resize(result.size());
+			{
+				std::vector<size_t> cursor(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+				for (size_t i = 0; i < result.size(); i++)
+				{
+					adjacency[cursor[result[i]]++] = static_cast<unsigned int>(i / 3);
+				}
+			}
+
+			// Both directions of every edge leaving an unlocked vertex, cheapest first
+			collapses.clear();
+			for (size_t i = 0; i < result.size(); i += 3)
+			{
+				for (int e = 0; e < 3; e++)
+				{
+					const unsigned int a = result[i + e];
+					const unsigned int b = result[i + (e + 1) % 3];
+					for (const auto& [from, to] : { std::make_pair(a, b), std::make_pair(b, a) })
+					{
+						if (!locked[canonical[from]])
+						{
+							Quadric q = quadrics[canonical[from]];
+							q += quadrics[canonical[to]];
+							collapses.push_back({ from, to, q.Evaluate(positions[to]) });
+						}
+					}
+				}
+			}
+			if (collapses.empty())
+			{
+				break;
+			}
+			std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a.cost < b.cost; });
+
+			// Most collapses remove two triangles; apply enough of them to get about halfway to the target,
+			// and only one per neighborhood, so each collapse can be checked against unchanged surroundings.
+			const size_t trianglesToRemove = (result.size() - targetIndexCount) / 3;
+			const size_t maxCollapses = std::max<size_t>(1, (trianglesToRemove + 1) / 2);
+			size_t numCollapses = 0;
+			for (unsigned int v = 0; v < numVertices; v++)
+			{
+				remap[v] = v;
+			}
+			std::fill(touched.begin(), touched.end(), false);
+
+			for (const auto& collapse : collapses)
+			{
+				if (numCollapses >= maxCollapses)
+				{
+					break;
+				}
+				const unsigned int from = collapse.from;
+				const unsigned int to = collapse.to;
+				if (touched[canonical[to]])
+				{
+					continue;
+				}
+
+				// Reject collapses next to one applied earlier in this pass, and ones which would flip or degenerate any triangle that survives
+				bool valid = true;
+				for (size_t i = adjacencyOffsets[from]; i < adjacencyOffsets[from + 1] && valid; i++)
+				{
+					const unsigned int* triangle = &result[adjacency[i] * 3];
+					if (touched[canonical[triangle[0]]] || touched[canonical[triangle[1]]] || touched[canonical[triangle[2]]])
+					{
+						valid = false;
+						break;
+					}
+					if (canonical[triangle[0]] == canonical[to] || canonical[triangle[1]] == canonical[to] || canonical[triangle[2]] == canonical[to])
+					{
+						continue;
+					}
+
+					glm::vec3 corners[3];
+					glm::vec3 moved[3];
+					for (int c = 0; c < 3; c++)
+					{
+						corners[c] = positions[triangle[c]];
+						moved[c] = (triangle[c] == from) ? positions[to] : corners[c];
+					}
+					const glm::vec3 before = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+					const glm::vec3 after = glm::cross(moved[1] - moved[0], moved[2] - moved[0]);
+					// Turning a triangle by more than 60 degrees creates slivers even where it doesn't flip
+					valid = glm::dot(before, after) > 0.5f * glm::length(before) * glm::length(after);
+				}
+				if (!valid)
+				{
+					continue;
+				}
+
+				remap[from] = to;
+				quadrics[canonical[to]] += quadrics[canonical[from]];
+				maxError = std::max(maxError, collapse.cost);
+				numCollapses++;
+
+				for (size_t i = adjacencyOffsets[from]; i < adjacencyOffsets[from + 1]; i++)
+				{
+					const unsigned int* triangle = &result[adjacency[i] * 3];
+					for (int c = 0; c < 3; c++)
+					{
+						touched[canonical[triangle[c]]] = true;
+					}
+				}
+			}
+			if (numCollapses == 0)
+			{
+				break;
+			}
+
+			size_t write = 0;
+			for (size_t i = 0; i < result.size(); i += 3)
+			{
+				const unsigned int a = remap[result[i]];
+				const unsigned int b = remap[result[i + 1]];
+				const unsigned int c = remap[result[i + 2]];
+				if (canonical[a] != canonical[b] && canonical[b] != canonical[c] && canonical[a] != canonical[c])
+				{
+					result[write++] = a;
+					result[write++] = b;
+					result[write++] = c;
+				}
+			}
+			result.resize(write);
+		}
+
+		resultError = static_cast<float>(std::sqrt(maxError));
+		return result;
+	}
+
+	void MeshSimplifier::GenerateLods(MeshData& mesh)
+	{
+		mesh.lods.clear();
+		if (mesh.indices.empty() || mesh.indices.size() % 3 != 0)
+		{
+			return;
+		}
+
+		mesh.lods.push_back(MeshLod{ 0, static_cast<unsigned int>(mesh.indices.size()), 0.0f });
+		std::vector<unsigned int> previous = mesh.indices;
+		float error = 0.0f;
+
+		while (mesh.lods.size() < k_maxLods && previous.size() / 6 >= k_minTriangles)
+		{
+			float levelError = 0.0f;
+			std::vector<unsigned int> level = Simplify(mesh.positions, previous, previous.size() / 6 * 3, levelError);
+			// Stop once a level would save less than a fifth of the previous one
+			if (level.size() * 5 > previous.size() * 4)
+			{
+				break;
+			}
+			MeshOptimizer::OptimizeVertexCache(level, mesh.positions.size());
+
+			// Errors of successive levels add up, as each is simplified from the one before
+			error += levelError;
+			mesh.lods.push_back(MeshLod{ static_cast<unsigned int>(mesh.indices.size()), static_cast<unsigned int>(level.size()), error });
+			mesh.indices.insert(mesh.indices.end(), level.begin(), level.end());
+			previous = std::move(level);
+		}
+
+		if (mesh.lods.size() == 1)
+		{
+			mesh.lods.clear();
+		}
+	}
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <vector>
+
+#include "Model.h"
+
+namespace sparkle
+{
+	// Quadric error metric simplification (Garland & Heckbert) by half-edge collapses.
+	// Vertices are only ever removed, never moved or created, so every level of detail
+	// indexes into the vertex buffer of the full-detail mesh.
+	// Vertices on open borders and attribute seams (UV or normal splits) are kept in place, so the
+	// silhouette of open meshes and texture mapping along seams stay intact.
+	class MeshSimplifier
+	{
+	public:
+		static const unsigned int k_maxLods = 6;
+		// No further levels once fewer triangles would remain
+		static const unsigned int k_minTriangles = 32;
+
+		/// <summary>
+		/// Collapses edges of the triangle list indices until at most targetIndexCount indices remain,
+		/// or no collapse is possible without flipping triangles.
+		/// </summary>
+		/// <param name="resultError">Receives the largest deviation introduced, in mesh space</param>
+		/// <returns>The simplified triangle list</returns>
+		static std::vector<unsigned int> Simplify(const std::vector<glm::vec3>& positions, const std::vector<unsigned int>& indices,
+			size_t targetIndexCount, float& resultError);
+
+		/// <summary>
+		/// Appends successively halved levels of detail to mesh.indices and fills in mesh.lods.
+		/// Expects welded vertices (see MeshOptimizer); stops early once simplification stalls.
+		/// </summary>
+		static void GenerateLods(MeshData& mesh);
+	};
+}
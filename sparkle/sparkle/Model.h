@@ -2,13 +2,65 @@
 
 #include <vector>
 #include <memory>
+#include <optional>
+#include <string>
 
 #include "Mesh.h"
 #include "MeshRenderer.h"
+#include "MappedFile.h"
 
 namespace sparkle
 {
 
+// CPU-side mesh attributes, as imported from disk.
+struct MeshData
+{
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec3> normals;
+	std::vector<glm::vec2> texCoords;
+	std::vector<unsigned int> indices;
+	// Levels of detail as ranges of indices; empty if indices form a single level
+	std::vector<MeshLod> lods;
+
+	MeshView view() const
+	{
+		MeshView result;
+		result.positions = positions.data();
+		result.normals = normals.empty() ? nullptr : normals.data();
+		result.texCoords = texCoords.empty() ? nullptr : texCoords.data();
+		result.indices = indices.empty() ? nullptr : indices.data();
+		result.numVertices = static_cast<unsigned int>(positions.size());
+		result.numIndices = static_cast<unsigned int>(indices.size());
+		result.lods = lods.empty() ? nullptr : lods.data();
+		result.numLods = static_cast<unsigned int>(lods.size());
+		return result;
+	}
+};
+
+// One mesh of an imported model, with the file names of its textures (relative to the model's directory).
+struct SubmeshData
+{
+	// Owned data when imported through Assimp...
+	MeshData mesh;
+	// ...or a view into ModelData::mapping when read from a cooked file.
+	std::optional<MeshView> cooked;
+
+	std::vector<std::string> diffuseMaps;
+	std::vector<std::string> specularMaps;
+
+	MeshView view() const
+	{
+		return cooked.has_value() ? *cooked : mesh.view();
+	}
+};
+
+// Result of importing a model from disk, before any GL objects are created.
+struct ModelData
+{
+	std::vector<SubmeshData> submeshes;
+	std::shared_ptr<MappedFile> mapping;
+};
+
 // Bundles constituent meshes and their renderers when loading a model from disk.
 // Not a component itself; the contained mesh renderers should be added to the actor instead,
 // so they can be discovered for rendering (we don't like nested components!)
@@ -21,6 +21,8 @@ namespace sparkle
 		PlayerController()
 		{
 			SET_COMPONENT_NAME
+			// All of its work happens in GodUpdate() on the main thread
+			threadSafe = true;
 		}
 
 		void Start() override
@@ -37,6 +39,9 @@ namespace sparkle
 			if (camera)
 			{
 				const auto& trans = camera->transform();
+				const glm::vec3 front = camera->front();
+				const glm::vec3 up = camera->up();
+				const glm::vec3 right = camera->right();
 				const float speedScalar = Global::Config::cameraTranslateSpeed;
 
 				static glm::vec3 currentVelocity(0);
@@ -44,33 +49,33 @@ namespace sparkle
 
 				if (Global::input->GetKey(GLFW_KEY_W))
 				{
-					targetVelocity += camera->front();
+					targetVelocity += front;
 				} 
 				else if (Global::input->GetKey(GLFW_KEY_S))
 				{
-					targetVelocity -= camera->front();
+					targetVelocity -= front;
 				}
 
 				if (Global::input->GetKey(GLFW_KEY_A))
 				{
-					targetVelocity -= glm::normalize(glm::cross(camera->front(), camera->up()));
+					targetVelocity -= right;
 				}
 				else if (Global::input->GetKey(GLFW_KEY_D))
 				{
-					targetVelocity += glm::normalize(glm::cross(camera->front(), camera->up()));
+					targetVelocity += right;
 				}
 
 				if (Global::input->GetKey(GLFW_KEY_Q))
 				{
-					targetVelocity += camera->up();
+					targetVelocity += up;
 				}
 				else if (Global::input->GetKey(GLFW_KEY_E))
 				{
-					targetVelocity -= camera->up();
+					targetVelocity -= up;
 				}
 
 				currentVelocity = utils::Lerp(currentVelocity, targetVelocity, Timer::deltaTime() * 10);
-				trans->position += currentVelocity * speedScalar * Timer::deltaTime();
+				trans->SetPosition(trans->position() + currentVelocity * speedScalar * Timer::deltaTime());
 			}
 			else
 			{
@@ -101,7 +106,7 @@ namespace sparkle
 
 			if (shouldRotate)
 			{
-				auto rot = Global::camera->transform()->rotation;
+				auto rot = Global::camera->transform()->eulerAngles();
 				float yaw = -rot.y;
 				float pitch = rot.x;
 
@@ -112,7 +117,7 @@ namespace sparkle
 				yaw += xoffset;
 				pitch = std::clamp(pitch + yoffset, -89.0f, 89.0f);
 
-				Global::camera->transform()->rotation = glm::vec3(pitch, -yaw, 0.0f);
+				Global::camera->transform()->SetEulerAngles(glm::vec3(pitch, -yaw, 0.0f));
 			}
 			lastX = (float)xpos;
 			lastY = (float)ypos;
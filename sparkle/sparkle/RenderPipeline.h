@@ -6,6 +6,8 @@
 #include "GameInstance.h"
 #include "Light.h"
 #include "MeshRenderer.h"
+#include "Camera.h"
+#include "JobSystem.h"
 
 namespace sparkle
 {
@@ -48,19 +50,116 @@ namespace sparkle
 			{
 				glDeleteTextures(1, &depthTex);
 			}
+			if (targetFrameBuffer > 0)
+			{
+				glDeleteFramebuffers(1, &targetFrameBuffer);
+				glDeleteRenderbuffers(2, m_targetRenderBuffers);
+			}
+		}
+
+		// Renders into a framebuffer of the given size instead of the window, for contexts without one (headless).
+		void CreateOffscreenTarget(glm::ivec2 size)
+		{
+			glGenRenderbuffers(2, m_targetRenderBuffers);
+			glBindRenderbuffer(GL_RENDERBUFFER, m_targetRenderBuffers[0]);
+			glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, size.x, size.y);
+			glBindRenderbuffer(GL_RENDERBUFFER, m_targetRenderBuffers[1]);
+			glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, size.x, size.y);
+
+			glGenFramebuffers(1, &targetFrameBuffer);
+			glBindFramebuffer(GL_FRAMEBUFFER, targetFrameBuffer);
+			glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_targetRenderBuffers[0]);
+			glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_targetRenderBuffers[1]);
+			if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+			{
+				fmt::print("Error(RenderPipeline): Offscreen framebuffer is incomplete.\n");
+			}
 		}
 
 		void Render()
 		{
-			std::vector<MeshRenderer*> renderers = Global::game->FindComponents<MeshRenderer>();
+			const std::vector<MeshRenderer*>& renderers = Global::game->FindComponents<MeshRenderer>();
+			SelectLods(renderers);
 			RenderShadow(renderers);
+			onPassEnd.Invoke("shadow");
 			RenderObjects(renderers);
+			onPassEnd.Invoke("objects");
 		}
 
+		// Invoked with the name of each render pass once its commands are submitted, e.g. for profiling
+		SpCallback<void(const char*)> onPassEnd;
+
 		unsigned int depthFrameBuffer = 0;
 		unsigned int depthTex = 0;
+		// Framebuffer the scene is rendered to; 0 for the window
+		unsigned int targetFrameBuffer = 0;
 
 	private:
+		static const unsigned int k_renderersPerJob = 256;
+
+		// Color and depth of the offscreen target
+		unsigned int m_targetRenderBuffers[2] = { 0, 0 };
+		// World matrices of the renderers passed to SelectLods(), by index
+		std::vector<glm::mat4> m_lodModelMatrices;
+
+		/// <summary>
+		/// Picks the coarsest LOD of each renderer whose simplification error, projected to the screen at the
+		/// distance of the mesh's bounding sphere, stays within Global::Config::lodPixelError.
+		/// Switching to a coarser LOD requires a margin (lodHysteresis), so objects near a threshold don't flicker.
+		/// </summary>
+		void SelectLods(const std::vector<MeshRenderer*>& renderers)
+		{
+			if (Global::camera == nullptr)
+			{
+				return;
+			}
+
+			// Pixels per world unit at distance 1
+			const float screenHeight = static_cast<float>(Global::game->windowSize().y);
+			const float projectionScale = screenHeight / (2.0f * glm::tan(glm::radians(Global::camera->zoom) * 0.5f));
+			const glm::vec3 cameraPosition = Global::camera->position();
+			const float maxError = Global::Config::lodPixelError;
+			const float maxCoarserError = maxError * (1.0f - Global::Config::lodHysteresis);
+
+			// Reading a transform may recompute it, which isn't thread-safe, and submeshes of a model share one,
+			// so the world matrices are gathered here before the jobs
+			m_lodModelMatrices.resize(renderers.size());
+			for (size_t i = 0; i < renderers.size(); i++)
+			{
+				const MeshRenderer* r = renderers[i];
+				if (r->enabled && r->mesh()->numLods() > 1)
+				{
+					m_lodModelMatrices[i] = r->actor->transform->matrix();
+				}
+			}
+
+			Global::jobs->ParallelFor(static_cast<unsigned int>(renderers.size()), [&](unsigned int i) {
+				MeshRenderer* r = renderers[i];
+				const auto& mesh = r->mesh();
+				if (!r->enabled || mesh->numLods() <= 1)
+				{
+					return;
+				}
+
+				const glm::mat4& model = m_lodModelMatrices[i];
+				const float scale = glm::max(glm::length(glm::vec3(model[0])), glm::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+				const glm::vec3 center = glm::vec3(model * glm::vec4(mesh->boundsCenter(), 1.0f));
+				const float distance = glm::max(glm::length(center - cameraPosition) - mesh->boundsRadius() * scale, 0.01f);
+				const float pixelsPerUnit = projectionScale * scale / distance;
+
+				unsigned int lod = glm::min(r->lod(), mesh->numLods() - 1);
+				while (lod > 0 && mesh->lod(lod).error * pixelsPerUnit > maxError)
+				{
+					lod--;
+				}
+				while (lod + 1 < mesh->numLods() && mesh->lod(lod + 1).error * pixelsPerUnit <= maxCoarserError)
+				{
+					lod++;
+				}
+				r->SetLod(lod);
+				}, k_renderersPerJob);
+		}
+
 		glm::mat4 ComputeLightMatrix()
 		{
 			if (Global::lights.size() == 0)
@@ -87,7 +186,7 @@ namespace sparkle
 			return lightSpaceMatrix;
 		}
 
-		void RenderShadow(std::vector<MeshRenderer*> renderers)
+		void RenderShadow(const std::vector<MeshRenderer*>& renderers)
 		{
 			if (Global::lights.empty())
 			{
@@ -100,6 +199,7 @@ namespace sparkle
 			glClear(GL_DEPTH_BUFFER_BIT);
 
 			glCullFace(GL_FRONT);
+			Global::frameStats.stateChanges += 2;
 
 			auto lightSpaceMatrix = ComputeLightMatrix();
 
@@ -111,15 +211,17 @@ namespace sparkle
 				}
 			}
 
-			glBindFramebuffer(GL_FRAMEBUFFER, 0);
+			glBindFramebuffer(GL_FRAMEBUFFER, targetFrameBuffer);
 			glViewport(0, 0, originalWindowSize.x, originalWindowSize.y);
+			Global::frameStats.stateChanges++;
 		}
 
-		void RenderObjects(std::vector<MeshRenderer*> renderers)
+		void RenderObjects(const std::vector<MeshRenderer*>& renderers)
 		{
 			// reset viewport
 			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 			glCullFace(GL_BACK);
+			Global::frameStats.stateChanges++;
 
 			auto lightSpaceMatrix = ComputeLightMatrix();
 
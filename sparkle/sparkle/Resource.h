@@ -6,6 +6,12 @@
 #include <utility>
 #include <optional>
 #include <filesystem>
+#include <future>
+#include <mutex>
+#include <deque>
+#include <atomic>
+#include <chrono>
+#include <functional>
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
@@ -17,6 +23,12 @@
 #include "Model.h"
 #include "Mesh.h"
 #include "Material.h"
+#include "JobSystem.h"
+#include "Global.h"
+#include "MeshCooker.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "TextureCooker.h"
 
 namespace sparkle
 {
@@ -35,44 +47,33 @@ namespace sparkle
 			glGenTextures(1, &textureID);
 			textureCache[path] = textureID;
 
-			int width, height, nrComponents;
-			unsigned char* data = stbi_load(path.c_str(), &width, &height, &nrComponents, 0);
-			if (data == nullptr)
+			UploadTexture(textureID, DecodeTexture(path));
+			return textureID;
+		}
+
+		/// <summary>
+		/// Asynchronous version of LoadTexture().
+		/// The returned texture is a 1x1 white placeholder until the image has been decoded on a worker thread;
+		/// ProcessUploads() then uploads the image into the same texture, so the handle can be used right away.
+		/// </summary>
+		/// <param name="path"></param>
+		/// <returns></returns>
+		static unsigned int LoadTextureAsync(const std::string& path)
+		{
+			if (textureCache.count(path) > 0)
 			{
-				data = stbi_load((defaultTexturePath + path).c_str(), &width, &height, &nrComponents, 0);
+				return textureCache[path];
 			}
-			if (data)
-			{
-				GLenum internalFormat = GL_RED;
-				GLenum dataFormat = GL_RED;
-
-				if (nrComponents == 3)
-				{
-					internalFormat = GL_SRGB;
-					dataFormat = GL_RGB;
-				}
-				else if (nrComponents == 4)
-				{
-					internalFormat = GL_SRGB_ALPHA;
-					dataFormat = GL_RGBA;
-				}
-
-				glBindTexture(GL_TEXTURE_2D, textureID);
-				glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, dataFormat, GL_UNSIGNED_BYTE, data);
-				glGenerateMipmap(GL_TEXTURE_2D);
 
-				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			unsigned int textureID;
+			glGenTextures(1, &textureID);
+			textureCache[path] = textureID;
+			UploadPlaceholderTexture(textureID);
 
-				stbi_image_free(data);
-			}
-			else
-			{
-				fmt::print("Error(Resource): Texture failed to load at path({})\n", path);
-				stbi_image_free(data);
-			}
+			LoadAsync([path, textureID]() {
+				auto texture = std::make_shared<TextureData>(DecodeTexture(path));
+				return [textureID, texture]() { UploadTexture(textureID, *texture); };
+			});
 			return textureID;
 		}
 
@@ -91,26 +92,44 @@ namespace sparkle
 				return meshCache[path];
 			}
 
-			
-			Assimp::Importer importer;
-			const aiScene* scene = importer.ReadFile(defaultMeshPath + path, aiProcess_Triangulate | aiProcess_GenNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
-			// check for errors
-			if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
+			std::optional<ModelData> data = ImportMesh(path);
+			if (!data.has_value())
 			{
-				scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
-
-				if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) // if is Not Zero
-				{
-					fmt::print("Error(Resource): Assimp error({})\n", importer.GetErrorString());
-					exit(-1);
-				}
+				exit(-1);
 			}
 
-			aiMesh* aiMesh = scene->mMeshes[0];
+			std::shared_ptr<Mesh> mesh = std::make_shared<Mesh>(data->submeshes[0].view());
+
+			meshCache[path] = mesh;
+			return mesh;
+		}
 
-			std::shared_ptr<Mesh> mesh = ProcessMesh(aiMesh, scene);
+		/// <summary>
+		/// Asynchronous version of LoadMesh().
+		/// The returned mesh is empty (draws nothing) until the import on a worker thread has finished;
+		/// ProcessUploads() then fills in the same mesh object.
+		/// </summary>
+		/// <param name="path"></param>
+		/// <returns></returns>
+		static std::shared_ptr<Mesh> LoadMeshAsync(const std::string& path)
+		{
+			if (meshCache.count(path) > 0)
+			{
+				return meshCache[path];
+			}
 
+			std::shared_ptr<Mesh> mesh = std::make_shared<Mesh>(std::vector<glm::vec3>());
 			meshCache[path] = mesh;
+
+			LoadAsync([path, mesh]() -> std::function<void()> {
+				auto data = std::make_shared<std::optional<ModelData>>(ImportMesh(path));
+				return [mesh, data]() {
+					if (data->has_value())
+					{
+						mesh->SetData((*data)->submeshes[0].view());
+					}
+				};
+			});
 			return mesh;
 		}
 		
@@ -128,34 +147,101 @@ namespace sparkle
 				return modelCache[path];
 			}
 
-			std::filesystem::path p(path);
-			if (!std::filesystem::exists(p))
+			if (!std::filesystem::exists(std::filesystem::path(path)))
 			{
 				fmt::print("Error(Resource): Model not found at path({})\n", path);
 				exit(-1);
 			}
-			std::filesystem::path modelDir = p.parent_path();
 
-			std::vector<std::shared_ptr<Mesh>> modelMeshes{};
-			std::vector<std::shared_ptr<MeshRenderer>> meshRenderers{};
+			std::optional<ModelData> data = ImportModel(path, flipUVs);
+			if (!data.has_value())
+			{
+				exit(-1);
+			}
 
-			unsigned int flipUV = flipUVs ? aiProcess_FlipUVs : 0;
+			auto result = BuildModel(*data, path, material, false);
+			modelCache[path] = result;
+			return result;
+		}
 
-			Assimp::Importer importer;
-			const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_GenNormals | flipUV | aiProcess_CalcTangentSpace);
-			// check for errors
-			if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
+		/// <summary>
+		/// Asynchronous version of LoadModel().
+		/// The model is imported on a worker thread, and its meshes and renderers are created by ProcessUploads()
+		/// on the main thread; its textures are then streamed in through LoadTextureAsync().
+		/// onLoaded is invoked on the main thread once the model exists, which is where its mesh renderers
+		/// should be added to an actor. The returned future becomes ready at the same point, so never block on it
+		/// from the main thread.
+		/// If the import fails, the error is logged, the future holds nullptr and onLoaded is not invoked.
+		/// A load cancelled by ClearCache() likewise resolves the future to nullptr and skips its callbacks.
+		/// </summary>
+		/// <param name="path"></param>
+		/// <returns></returns>
+		static std::shared_future<std::shared_ptr<Model>> LoadModelAsync(
+			const std::string& path,
+			const std::shared_ptr<Material>& material,
+			std::function<void(std::shared_ptr<Model>)> onLoaded = nullptr,
+			bool flipUVs = true)
+		{
+			if (modelCache.count(path) > 0)
 			{
-				fmt::println("ERROR::ASSIMP::{}", importer.GetErrorString());
+				std::promise<std::shared_ptr<Model>> promise;
+				promise.set_value(modelCache[path]);
+				if (onLoaded)
+				{
+					onLoaded(modelCache[path]);
+				}
+				return promise.get_future().share();
+			}
+
+			if (pendingModels.count(path) > 0)
+			{
+				auto& pending = pendingModels[path];
+				if (onLoaded)
+				{
+					pending->callbacks.push_back(onLoaded);
+				}
+				return pending->future;
+			}
+
+			if (!std::filesystem::exists(std::filesystem::path(path)))
+			{
+				fmt::print("Error(Resource): Model not found at path({})\n", path);
 				exit(-1);
 			}
 
-			// process ASSIMP's root node recursively, adding to the modelMeshes and modelMaterials vectors
-			ProcessNode(scene->mRootNode, scene, material, modelMeshes, meshRenderers, modelDir);
+			auto pending = std::make_shared<PendingModel>();
+			pending->future = pending->promise.get_future().share();
+			if (onLoaded)
+			{
+				pending->callbacks.push_back(onLoaded);
+			}
+			pendingModels[path] = pending;
 
-			auto result = std::make_shared<Model>(std::move(modelMeshes), std::move(meshRenderers));
-			modelCache[path] = result;
-			return result;
+			LoadAsync([path, material, flipUVs]() -> std::function<void()> {
+				auto data = std::make_shared<std::optional<ModelData>>(ImportModel(path, flipUVs));
+				return [path, material, data]() {
+					auto pending = pendingModels[path];
+					pendingModels.erase(path);
+
+					std::shared_ptr<Model> model = nullptr;
+					if (data->has_value())
+					{
+						model = BuildModel(**data, path, material, true);
+						modelCache[path] = model;
+					}
+					pending->promise.set_value(model);
+					if (!model)
+					{
+						fmt::print("Error(Resource): Failed to load model({}); skipping its {} onLoaded callback(s)\n", path, pending->callbacks.size());
+						return;
+					}
+					for (const auto& callback : pending->callbacks)
+					{
+						callback(model);
+					}
+				};
+			});
+			return pending->future;
 		}
 
 		static std::shared_ptr<Material> LoadMaterial(const std::string& path, bool includeGeometryShader = false)
@@ -237,6 +323,49 @@ namespace sparkle
 			return code;
 		}
 
+		/// <summary>
+		/// Runs the GL work queued by asynchronous loads until the time budget is spent.
+		/// Must be called from the thread owning the GL context; GameInstance calls it once per frame.
+		/// At least one queued upload is processed per call, so loading always makes progress.
+		/// </summary>
+		/// <param name="budgetMilliseconds"></param>
+		static void ProcessUploads(double budgetMilliseconds)
+		{
+			const auto start = std::chrono::steady_clock::now();
+			while (true)
+			{
+				PendingUpload upload;
+				{
+					std::lock_guard<std::mutex> lock(uploadMutex);
+					if (uploadQueue.empty())
+					{
+						return;
+					}
+					upload = std::move(uploadQueue.front());
+					uploadQueue.pop_front();
+				}
+
+				// Loads started before the last ClearCache() refer to released resources; cancelled loads have no task.
+				if (upload.generation == loadGeneration && upload.task)
+				{
+					upload.task();
+				}
+				pendingLoadCount--;
+
+				std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+				if (elapsed.count() > budgetMilliseconds)
+				{
+					return;
+				}
+			}
+		}
+
+		// Returns the number of asynchronous loads which are not yet uploaded.
+		static int numPendingLoads()
+		{
+			return pendingLoadCount;
+		}
+
 		static void ClearCache()
 		{
 			for(auto& [key, value] : textureCache)
@@ -248,46 +377,355 @@ namespace sparkle
 			meshCache.clear();
 			modelCache.clear();
 			materialCache.clear();
+
+			loadGeneration++;
+			// Their uploads are discarded now, so resolve the futures here rather than leave their promises broken
+			for (auto& [key, pending] : pendingModels)
+			{
+				pending->promise.set_value(nullptr);
+			}
+			pendingModels.clear();
 		}
 
+		// Format textures are cooked to; RGB(A) textures are cooked on first load and read from <path>.sptx afterwards.
+		static inline TextureFormat textureFormat = TextureFormat::Auto;
+
+		// Whether imported meshes are welded and reordered by MeshOptimizer before cooking.
+		static inline bool optimizeMeshes = true;
+		// Whether imported meshes get a chain of simplified LODs. Requires optimizeMeshes, which welds their vertices.
+		static inline bool generateLods = true;
+
 	private:
+		// Either a cooked mip chain, or a decoded image owned by stb_image (grey textures are not cooked).
+		struct TextureData
+		{
+			std::optional<CookedTexture> cooked;
+			int width = 0;
+			int height = 0;
+			int numComponents = 0;
+			std::shared_ptr<unsigned char> pixels;
+			std::string path;
+		};
+
+		struct PendingUpload
+		{
+			unsigned int generation = 0;
+			std::function<void()> task;
+		};
+
+		struct PendingModel
+		{
+			std::promise<std::shared_ptr<Model>> promise;
+			std::shared_future<std::shared_ptr<Model>> future;
+			std::vector<std::function<void(std::shared_ptr<Model>)>> callbacks;
+		};
+
+		static JobSystem& Jobs()
+		{
+			return *Global::jobs;
+		}
+
+		/// <summary>
+		/// Runs load on a worker thread. load must not touch OpenGL; it returns the GL work
+		/// which is then queued for ProcessUploads() on the main thread.
+		/// </summary>
+		/// <param name="load"></param>
+		static void LoadAsync(std::function<std::function<void()>()> load)
+		{
+			const unsigned int generation = loadGeneration;
+			pendingLoadCount++;
+			Jobs().Enqueue([load, generation]() {
+				// Skip the work of loads that were cancelled while queued; the upload still retires pendingLoadCount
+				const bool cancelled = generation != loadGeneration || Jobs().stopping();
+				PendingUpload upload{ generation, cancelled ? nullptr : load() };
+				std::lock_guard<std::mutex> lock(uploadMutex);
+				uploadQueue.push_back(std::move(upload));
+			});
+		}
+
+		static TextureData DecodeTexture(const std::string& path)
+		{
+			TextureData result;
+			result.path = path;
+
+			std::string sourcePath = path;
+			if (!std::filesystem::exists(sourcePath))
+			{
+				sourcePath = defaultTexturePath + path;
+			}
+
+			result.cooked = TextureCooker::Load(sourcePath, textureFormat);
+			if (!result.cooked.has_value())
+			{
+				result.cooked = TextureCooker::Cook(sourcePath, textureFormat, Jobs());
+			}
+			if (result.cooked.has_value())
+			{
+				return result;
+			}
+
+			unsigned char* data = stbi_load(sourcePath.c_str(), &result.width, &result.height, &result.numComponents, 0);
+			if (data)
+			{
+				result.pixels = std::shared_ptr<unsigned char>(data, stbi_image_free);
+			}
+			return result;
+		}
+
+		static void UploadTexture(unsigned int textureID, const TextureData& texture)
+		{
+			if (texture.cooked.has_value())
+			{
+				const CookedTexture& cooked = *texture.cooked;
+				glBindTexture(GL_TEXTURE_2D, textureID);
+				for (size_t level = 0; level < cooked.levels.size(); level++)
+				{
+					const TextureLevel& data = cooked.levels[level];
+					if (cooked.compressed())
+					{
+						glCompressedTexImage2D(GL_TEXTURE_2D, (GLint)level, cooked.glInternalFormat, data.width, data.height, 0, (GLsizei)data.size, data.data);
+					}
+					else
+					{
+						glTexImage2D(GL_TEXTURE_2D, (GLint)level, cooked.glInternalFormat, data.width, data.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data.data);
+					}
+				}
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)cooked.levels.size() - 1);
+
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			}
+			else if (texture.pixels)
+			{
+				GLenum internalFormat = GL_RED;
+				GLenum dataFormat = GL_RED;
+
+				if (texture.numComponents == 3)
+				{
+					internalFormat = GL_SRGB;
+					dataFormat = GL_RGB;
+				}
+				else if (texture.numComponents == 4)
+				{
+					internalFormat = GL_SRGB_ALPHA;
+					dataFormat = GL_RGBA;
+				}
+
+				glBindTexture(GL_TEXTURE_2D, textureID);
+				glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, texture.width, texture.height, 0, dataFormat, GL_UNSIGNED_BYTE, texture.pixels.get());
+				glGenerateMipmap(GL_TEXTURE_2D);
+
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			}
+			else
+			{
+				fmt::print("Error(Resource): Texture failed to load at path({})\n", texture.path);
+			}
+		}
+
+		static void UploadPlaceholderTexture(unsigned int textureID)
+		{
+			const unsigned char white[4] = { 255, 255, 255, 255 };
+			glBindTexture(GL_TEXTURE_2D, textureID);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_SRGB_ALPHA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, white);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		}
+
+		/// <summary>
+		/// Imports the first mesh of the scene at path, from its cooked file if that is up to date.
+		/// Safe to call from worker threads.
+		/// </summary>
+		/// <param name="path"></param>
+		/// <returns>An empty optional if the import failed</returns>
+		static std::optional<ModelData> ImportMesh(const std::string& path)
+		{
+			// Bit outside of the Assimp flags we use, so cooked single meshes never match cooked models.
+			const unsigned int k_firstMeshOnly = 1u << 31;
+			// Cooked next to the model's own cooked file instead of over it, so importing a source both ways
+			// doesn't re-cook it on every load
+			const std::string k_firstMeshVariant = ".mesh0";
+
+			std::string sourcePath = defaultMeshPath + path;
+			unsigned int flags = aiProcess_Triangulate | aiProcess_GenNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace;
+			if (!std::filesystem::exists(sourcePath))
+			{
+				sourcePath = path;
+				flags = aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace;
+			}
+
+			const unsigned int importKey = flags | k_firstMeshOnly | ProcessingKey();
+			std::optional<ModelData> cooked = MeshCooker::Load(sourcePath, importKey, k_firstMeshVariant);
+			if (cooked.has_value() && cooked->submeshes.size() == 1)
+			{
+				return cooked;
+			}
+
+			Assimp::Importer importer;
+			const aiScene* scene = importer.ReadFile(sourcePath, flags);
+			// check for errors
+			if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) // if is Not Zero
+			{
+				fmt::print("Error(Resource): Assimp error({})\n", importer.GetErrorString());
+				return {};
+			}
+
+			ModelData result;
+			result.submeshes.emplace_back();
+			result.submeshes[0].mesh = ProcessMesh(scene->mMeshes[0]);
+			ProcessMeshes(result, sourcePath);
+			MeshCooker::Cook(sourcePath, importKey, result, k_firstMeshVariant);
+			return result;
+		}
+
+		/// <summary>
+		/// Imports all meshes of the model at path, along with the names of their textures.
+		/// Uses the cooked file of the model if it is up to date, and otherwise imports through Assimp and cooks it.
+		/// Safe to call from worker threads.
+		/// </summary>
+		/// <param name="path"></param>
+		/// <returns>An empty optional if the import failed</returns>
+		static std::optional<ModelData> ImportModel(const std::string& path, bool flipUVs)
+		{
+			unsigned int flipUV = flipUVs ? aiProcess_FlipUVs : 0;
+			const unsigned int flags = aiProcess_Triangulate | aiProcess_GenNormals | flipUV | aiProcess_CalcTangentSpace;
+			const unsigned int importKey = flags | ProcessingKey();
+
+			std::optional<ModelData> cooked = MeshCooker::Load(path, importKey);
+			if (cooked.has_value())
+			{
+				return cooked;
+			}
+
+			Assimp::Importer importer;
+			const aiScene* scene = importer.ReadFile(path, flags);
+			// check for errors
+			if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
+			{
+				fmt::println("ERROR::ASSIMP::{}", importer.GetErrorString());
+				return {};
+			}
+
+			// process ASSIMP's root node recursively, adding to the submeshes
+			ModelData result;
+			ProcessNode(scene->mRootNode, scene, result.submeshes);
+			ProcessMeshes(result, path);
+			MeshCooker::Cook(path, importKey, result);
+			return result;
+		}
+
+		// Part of the cooked file key, so toggling optimizeMeshes or generateLods re-cooks.
+		// Uses the bits of aiProcess_DropNormals and aiProcess_ForceGenNormals, which we never set.
+		static unsigned int ProcessingKey()
+		{
+			unsigned int result = 0;
+			if (optimizeMeshes)
+			{
+				result |= 1u << 30;
+				result |= generateLods ? (1u << 29) : 0;
+			}
+			return result;
+		}
+
+		static void ProcessMeshes(ModelData& data, const std::string& path)
+		{
+			if (!optimizeMeshes)
+			{
+				return;
+			}
+
+			size_t numTriangles = 0, verticesBefore = 0, verticesAfter = 0;
+			float missesBefore = 0.0f, missesAfter = 0.0f;
+			for (auto& submesh : data.submeshes)
+			{
+				MeshOptimizer::Stats stats = MeshOptimizer::Optimize(submesh.mesh);
+				numTriangles += stats.numTriangles;
+				verticesBefore += stats.verticesBefore;
+				verticesAfter += stats.verticesAfter;
+				missesBefore += stats.acmrBefore * stats.numTriangles;
+				missesAfter += stats.acmrAfter * stats.numTriangles;
+
+				if (generateLods)
+				{
+					MeshSimplifier::GenerateLods(submesh.mesh);
+				}
+			}
+
+			if (numTriangles > 0)
+			{
+				fmt::print("Info(MeshOptimizer): Optimized mesh({}): vertices {} -> {}, ACMR {:.3f} -> {:.3f}\n",
+					path, verticesBefore, verticesAfter, missesBefore / numTriangles, missesAfter / numTriangles);
+			}
+		}
+
+		/// <summary>
+		/// Creates the meshes and mesh renderers of an imported model. Must be called on the main thread.
+		/// </summary>
+		static std::shared_ptr<Model> BuildModel(const ModelData& data, const std::string& path, const std::shared_ptr<Material>& mat, bool loadTexturesAsync)
+		{
+			const std::filesystem::path modelDir = std::filesystem::path(path).parent_path();
+			std::vector<std::shared_ptr<Mesh>> modelMeshes{};
+			std::vector<std::shared_ptr<MeshRenderer>> meshRenderers{};
+
+			for (const auto& submesh : data.submeshes)
+			{
+				modelMeshes.push_back(std::make_shared<Mesh>(submesh.view()));
+
+				std::optional<MaterialProperty> materialProperty = ProcessMeshMaterial(submesh, modelDir, loadTexturesAsync);
+				MeshRenderer meshRenderer(modelMeshes.back(), mat, true);
+				if (materialProperty.has_value())
+				{
+					meshRenderer.SetMaterialProperty(*materialProperty);
+				}
+				meshRenderers.push_back(std::make_shared<MeshRenderer>(meshRenderer));
+			}
+
+			return std::make_shared<Model>(std::move(modelMeshes), std::move(meshRenderers));
+		}
+
 		static void ProcessNode(
 			aiNode* node,
 			const aiScene* scene,
-			const std::shared_ptr<Material>& mat,
-			std::vector<std::shared_ptr<Mesh>>& modelMeshes,
-			std::vector<std::shared_ptr<MeshRenderer>>& modelMeshRenderers,
-			const std::filesystem::path& modelDir)
+			std::vector<SubmeshData>& submeshes)
 		{
 			// process all the node's meshes (if any)
 			for (unsigned int i = 0; i < node->mNumMeshes; i++)
 			{
 				aiMesh* aiMesh = scene->mMeshes[node->mMeshes[i]];
-				std::shared_ptr<Mesh> mesh = ProcessMesh(aiMesh, scene);
-				modelMeshes.push_back(mesh);
-
-				std::optional<MaterialProperty> materialProperty = ProcessMeshMaterial(aiMesh, scene, modelDir);
-				MeshRenderer meshRenderer(modelMeshes.back(), mat, true);
-				if (materialProperty.has_value())
+				SubmeshData submesh;
+				submesh.mesh = ProcessMesh(aiMesh);
+				if (aiMesh->mMaterialIndex >= 0)
 				{
-					meshRenderer.SetMaterialProperty(*materialProperty);
+					aiMaterial* material = scene->mMaterials[aiMesh->mMaterialIndex];
+					submesh.diffuseMaps = GetMaterialTextureNames(material, aiTextureType_DIFFUSE);
+					submesh.specularMaps = GetMaterialTextureNames(material, aiTextureType_SPECULAR);
 				}
-				modelMeshRenderers.push_back(std::make_shared<MeshRenderer>(meshRenderer));
+				submeshes.push_back(std::move(submesh));
 			}
 			// then do the same for each of its children
 			for (unsigned int i = 0; i < node->mNumChildren; i++)
 			{
-				ProcessNode(node->mChildren[i], scene, mat, modelMeshes, modelMeshRenderers, modelDir);
+				ProcessNode(node->mChildren[i], scene, submeshes);
 			}
 		}
 
-		static std::shared_ptr<Mesh> ProcessMesh(aiMesh* mesh, const aiScene* scene)
+		static MeshData ProcessMesh(aiMesh* mesh)
 		{
-			std::vector<glm::vec3> vertices{};
-			std::vector<glm::vec3> normals{};
-			std::vector<glm::vec2> texCoords{};
-			std::vector<unsigned int> indices{};
-			int drawCount = mesh->mNumVertices;
+			MeshData result;
+			std::vector<glm::vec3>& vertices = result.positions;
+			std::vector<glm::vec3>& normals = result.normals;
+			std::vector<glm::vec2>& texCoords = result.texCoords;
+			std::vector<unsigned int>& indices = result.indices;
+
+			vertices.reserve(mesh->mNumVertices);
+			normals.reserve(mesh->mNumVertices);
+			texCoords.reserve(mesh->mNumVertices);
+			indices.reserve(mesh->mNumFaces * 3);
 
 			for (unsigned int i = 0; i < mesh->mNumVertices; i++)
 			{
@@ -325,57 +763,62 @@ namespace sparkle
 				}
 			}
 
-			return std::make_shared<Mesh>(std::move(vertices), std::move(normals), std::move(texCoords), std::move(indices));
+			return result;
 		}
 
-		static std::optional<MaterialProperty> ProcessMeshMaterial(aiMesh* mesh, const aiScene* scene, const std::filesystem::path& modelDir)
+		static std::optional<MaterialProperty> ProcessMeshMaterial(const SubmeshData& submesh, const std::filesystem::path& modelDir, bool loadTexturesAsync)
 		{
-			if (mesh->mMaterialIndex >= 0)
+			std::vector<unsigned int> diffuseMaps = LoadMaterialTextures(submesh.diffuseMaps, modelDir, loadTexturesAsync);
+			std::vector<unsigned int> specularMaps = LoadMaterialTextures(submesh.specularMaps, modelDir, loadTexturesAsync);
+
+			if (diffuseMaps.size() == 0 && specularMaps.size() == 0)
 			{
-				aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
-				std::vector<unsigned int> diffuseMaps = loadMaterialTextures(material, aiTextureType_DIFFUSE, modelDir);
-				std::vector<unsigned int> specularMaps = loadMaterialTextures(material, aiTextureType_SPECULAR, modelDir);
+				return {};
+			}
 
-				if (diffuseMaps.size() == 0 && specularMaps.size() == 0)
+			MaterialProperty materialProperty{};
+			materialProperty.preRendering = [diffuseMaps, specularMaps](Material* mat)
+			{
+				if (diffuseMaps.size() > 0)
 				{
-					return {};
+					mat->SetBool("material.useTexture", true);
+					mat->SetTexture("material.diffuse", diffuseMaps[0]);
 				}
-
-				MaterialProperty materialProperty{};
-				materialProperty.preRendering = [diffuseMaps, specularMaps](Material* mat)
+				if (specularMaps.size() > 0)
 				{
-					if (diffuseMaps.size() > 0)
-					{
-						mat->SetBool("material.useTexture", true);
-						mat->SetTexture("material.diffuse", diffuseMaps[0]);
-					}
-					if (specularMaps.size() > 0)
-					{
-						// TODO Our shader doesn't use a specular map yet! Add that.
-						// mat->SetBool("material.useTexture", true);
-						// mat->SetTexture("material.specular", specularMaps[0]);
-					}
-				};
-
-				if (diffuseMaps.size() > 1 || specularMaps.size() > 1)
-				{
-					fmt::print("ERROR(Resource): Multiple textures not supported, but multiple found in model loading.\n");
+					// TODO Our shader doesn't use a specular map yet! Add that.
+					// mat->SetBool("material.useTexture", true);
+					// mat->SetTexture("material.specular", specularMaps[0]);
 				}
+			};
 
-				return materialProperty;
+			if (diffuseMaps.size() > 1 || specularMaps.size() > 1)
+			{
+				fmt::print("ERROR(Resource): Multiple textures not supported, but multiple found in model loading.\n");
 			}
-			else return {};
+
+			return materialProperty;
 		}
 
-		static std::vector<unsigned int> loadMaterialTextures(aiMaterial* mat, aiTextureType type, const std::filesystem::path& modelDir)
+		static std::vector<std::string> GetMaterialTextureNames(aiMaterial* mat, aiTextureType type)
 		{
-			std::vector<unsigned int> textures;
+			std::vector<std::string> names;
 			for (unsigned int i = 0; i < mat->GetTextureCount(type); i++)
 			{
 				aiString str;
 				mat->GetTexture(type, i, &str);
-				const std::filesystem::path p = modelDir / str.C_Str();
-				unsigned int id = Resource::LoadTexture(p.string());
+				names.push_back(str.C_Str());
+			}
+			return names;
+		}
+
+		static std::vector<unsigned int> LoadMaterialTextures(const std::vector<std::string>& names, const std::filesystem::path& modelDir, bool loadAsync)
+		{
+			std::vector<unsigned int> textures;
+			for (const auto& name : names)
+			{
+				const std::filesystem::path p = modelDir / name;
+				unsigned int id = loadAsync ? Resource::LoadTextureAsync(p.string()) : Resource::LoadTexture(p.string());
 				textures.push_back(id);
 			}
 			return textures;
@@ -385,9 +828,16 @@ namespace sparkle
 		static inline std::unordered_map<std::string, std::shared_ptr<Mesh>> meshCache;
 		static inline std::unordered_map<std::string, std::shared_ptr<Material>> materialCache;
 		static inline std::unordered_map<std::string, std::shared_ptr<Model>> modelCache;
+		static inline std::unordered_map<std::string, std::shared_ptr<PendingModel>> pendingModels;
+
+		// Changed on the main thread only; loads and uploads queued under an older generation are discarded.
+		static inline std::atomic<unsigned int> loadGeneration = 0;
+		static inline std::atomic<int> pendingLoadCount = 0;
+		static inline std::mutex uploadMutex;
+		static inline std::deque<PendingUpload> uploadQueue;
 
 		static inline std::string defaultTexturePath = "Assets/Texture/";
 		static inline std::string defaultMeshPath = "Assets/Model/";
 		static inline std::string defaultMaterialPath = "Assets/Shader/";
 	};
-}
\ No newline at end of file
+}
@@ -17,6 +17,7 @@
 #include "Resource.h"
 #include "Input.h"
 #include "GUI.h"
+#include "JobSystem.h"
 
 namespace sparkle
 {
@@ -25,18 +26,55 @@ namespace sparkle
 		fmt::print("Error(Glfw): Code({}), {}\n", error, description);
 	}
 
-	SpEngine::SpEngine()
+	SpEngine::SpEngine(const EngineOptions& options) : m_options(options)
 	{
 		Global::engine = this;
+		m_jobs = std::make_unique<JobSystem>();
+		Global::jobs = m_jobs.get();
+		m_nextSceneIndex = options.sceneIndex;
+		if (m_options.benchmark.enabled)
+		{
+			// The benchmark ends the run once it has measured all frames; how many frames that takes depends on loading
+			m_options.maxFrames = 0;
+			m_benchmark = std::make_unique<Benchmark>(m_options.benchmark);
+		}
+
 		// setup glfw
+		glfwSetErrorCallback(PrintGlfwError);
+		if (m_options.headless)
+		{
+			// No display server needed; windows only exist in memory
+			glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+		}
 		glfwInit();
 		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
 		glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
 		glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 		// Multi-sample anti-aliasing
-		glfwWindowHint(GLFW_SAMPLES, 4);
+		glfwWindowHint(GLFW_SAMPLES, m_options.headless ? 0 : 4);
 
-		m_window = glfwCreateWindow(Global::Config::screenWidth, Global::Config::screenHeight, "Sparkle", NULL, NULL);
+		if (m_options.headless)
+		{
+			glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+			// Surfaceless EGL where the driver supports it (Mesa, NVIDIA), software OSMesa otherwise
+			for (int api : { GLFW_EGL_CONTEXT_API, GLFW_OSMESA_CONTEXT_API })
+			{
+				glfwWindowHint(GLFW_CONTEXT_CREATION_API, api);
+				m_window = glfwCreateWindow(Global::Config::screenWidth, Global::Config::screenHeight, "Sparkle", NULL, NULL);
+				if (m_window != NULL)
+				{
+					break;
+				}
+			}
+			if (m_options.maxFrames == 0 && !m_options.benchmark.enabled)
+			{
+				fmt::print("Warning(SpEngine): Headless runs without a frame limit never end.\n");
+			}
+		}
+		else
+		{
+			m_window = glfwCreateWindow(Global::Config::screenWidth, Global::Config::screenHeight, "Sparkle", NULL, NULL);
+		}
 
 		if (m_window == NULL)
 		{
@@ -52,16 +90,6 @@ namespace sparkle
 			glViewport(0, 0, width, height);
 			});
 
-		glfwSetCursorPosCallback(m_window, [](GLFWwindow* m_window, double xpos, double ypos) {
-			Global::game->ProcessMouse(m_window, xpos, ypos);
-			});
-
-		glfwSetScrollCallback(m_window, [](GLFWwindow* m_window, double xoffset, double yoffset) {
-			Global::game->ProcessScroll(m_window, xoffset, yoffset);
-			});
-
-		glfwSetErrorCallback(PrintGlfwError);
-
 		// setup opengl
 		if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
 		{
@@ -77,13 +105,29 @@ namespace sparkle
 		stbi_set_flip_vertically_on_load(true);
 
 		// setup members
-		m_gui = std::make_shared<GUI>(m_window);
+		if (!m_options.headless)
+		{
+			m_gui = std::make_shared<GUI>(m_window);
+		}
+		// After the GUI, whose callbacks Input passes its events on to
 		m_input = std::make_unique<Input>(m_window);
+		if (!m_options.replayInputPath.empty())
+		{
+			m_input->StartReplay(m_options.replayInputPath);
+		}
+		else if (!m_options.recordInputPath.empty())
+		{
+			m_input->StartRecording(m_options.recordInputPath);
+		}
+		m_initialized = true;
 	}
 
 	SpEngine::~SpEngine()
 	{
-		m_gui->ShutDown();
+		if (m_gui)
+		{
+			m_gui->ShutDown();
+		}
 		glfwTerminate();
 	}
 
@@ -94,6 +138,27 @@ namespace sparkle
 
 	int SpEngine::Run()
 	{
+		if (!m_initialized)
+		{
+			fmt::print("Error(SpEngine): No window or OpenGL context; nothing to run.\n");
+			return -1;
+		}
+		if (!m_options.sceneName.empty())
+		{
+			auto scene = std::find_if(scenes.begin(), scenes.end(), [this](const auto& s) { return s->name == m_options.sceneName; });
+			if (scene == scenes.end())
+			{
+				fmt::print("Error(SpEngine): No scene named \"{}\".\n", m_options.sceneName);
+				return -1;
+			}
+			m_nextSceneIndex = static_cast<unsigned int>(scene - scenes.begin());
+		}
+		if (m_nextSceneIndex >= scenes.size())
+		{
+			fmt::print("Error(SpEngine): Scene index {} is out of range ({} scenes).\n", m_nextSceneIndex, scenes.size());
+			return -1;
+		}
+
 		do {
 			fmt::print("Sparkle Engine\n");
 			m_game = std::make_unique<GameInstance>(m_window, m_gui);
@@ -102,15 +167,22 @@ namespace sparkle
 			// This is fine for now, but we should consider caching the compiled shaders (and assets...)
 			scenes[sceneIndex]->PopulateActors(m_game.get());
 			scenes[sceneIndex]->onEnter.Invoke();
+			if (m_benchmark)
+			{
+				m_benchmark->Attach(m_game.get(), scenes[sceneIndex]->name);
+			}
 			m_game->Run();
 			scenes[sceneIndex]->onExit.Invoke();
 			scenes[sceneIndex]->ClearCallbacks();
 
 			Resource::ClearCache();
-			m_gui->ClearCallback();
+			if (m_gui)
+			{
+				m_gui->ClearCallback();
+			}
 		} while (m_game->pendingReset);
 
-		return 0;
+		return m_benchmark ? m_benchmark->Finish() : 0;
 	}
 
 	void SpEngine::Reset()
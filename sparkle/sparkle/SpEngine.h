@@ -8,17 +8,42 @@
 #include <GLFW/glfw3.h>
 #include <glm.hpp>
 
+#include "Benchmark.h"
+
 namespace sparkle
 {
 	class Scene;
 	class GUI;
 	class GameInstance;
 	class Input;
+	class JobSystem;
+
+	struct EngineOptions
+	{
+		// Runs without a windowing system, e.g. on compute nodes: GLFW's null platform with an offscreen
+		// OpenGL context (EGL surfaceless, or OSMesa), no GUI, and a simulated clock that advances one
+		// fixed step per frame, so results don't depend on how fast the machine is.
+		bool headless = false;
+		// Headless only: render every frame into an offscreen framebuffer. Without it nothing is drawn,
+		// and the context only holds the resources scenes create.
+		bool renderOffscreen = false;
+		// Frames to run before the engine exits; 0 runs until the window is closed. Headless runs need a limit.
+		unsigned int maxFrames = 0;
+		unsigned int sceneIndex = 0;
+		// Selects the scene by Scene::name instead of sceneIndex if set
+		std::string sceneName;
+		// Writes the input of the run to a file (see Input::StartRecording)
+		std::string recordInputPath;
+		// Plays a recorded run back instead of taking live input; the engine exits when it ends
+		std::string replayInputPath;
+		// Runs warmupFrames + measuredFrames frames of the scene and exits with the benchmark's result
+		BenchmarkOptions benchmark;
+	};
 
 	class SpEngine
 	{
 	public:
-		SpEngine();
+		SpEngine(const EngineOptions& options = EngineOptions());
 		~SpEngine();
 
 		int Run();
@@ -29,13 +54,30 @@ namespace sparkle
 
 		glm::ivec2 windowSize();
 
+		const EngineOptions& options() const
+		{
+			return m_options;
+		}
+
+		// Whether frames are drawn at all; false for headless runs without offscreen rendering
+		bool renders() const
+		{
+			return !m_options.headless || m_options.renderOffscreen;
+		}
+
 		std::vector<std::shared_ptr<Scene>> scenes;
 		unsigned int sceneIndex = 0;
 	private:
+		// Declared first, so it outlives everything which may schedule jobs
+		std::unique_ptr<JobSystem> m_jobs;
+		EngineOptions m_options;
 		unsigned int m_nextSceneIndex = 0;
 		GLFWwindow* m_window = nullptr;
+		// False if the constructor failed to create the window or load OpenGL
+		bool m_initialized = false;
 		std::shared_ptr<GUI> m_gui;
 		std::unique_ptr<GameInstance> m_game;
 		std::unique_ptr<Input> m_input;
+		std::unique_ptr<Benchmark> m_benchmark;
 	};
 }
\ No newline at end of file
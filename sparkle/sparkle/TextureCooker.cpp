@@ -0,0 +1,661 @@
+#include "TextureCooker.h"
+
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+#include <climits>
+#include <cfloat>
+
+#include <fmt/core.h>
+
+#include "stb_image.h"
+
+namespace sparkle
+{
+	namespace
+	{
+		const uint32_t k_magic = 0x58545053; // "SPTX"
+		const uint32_t k_version = 1;
+		const uint64_t k_alignment = 16;
+		const uint32_t k_maxLevels = 32;
+
+		struct Header
+		{
+			uint32_t magic;
+			uint32_t version;
+			uint32_t requestedFormat;
+			uint32_t format;
+			uint32_t glInternalFormat;
+			uint32_t width;
+			uint32_t height;
+			uint32_t levelCount;
+		};
+
+		struct LevelEntry
+		{
+			uint64_t offset;
+			uint64_t size;
+			uint32_t width;
+			uint32_t height;
+		};
+
+		// RGBA image in linear space
+		struct Image
+		{
+			unsigned int width = 0;
+			unsigned int height = 0;
+			std::vector<float> pixels;
+		};
+
+		uint64_t Align(uint64_t offset)
+		{
+			return (offset + k_alignment - 1) & ~(k_alignment - 1);
+		}
+
+		float SrgbToLinear(float c)
+		{
+			return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+		}
+
+		float LinearToSrgb(float c)
+		{
+			return c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+		}
+
+		uint8_t ToByte(float value)
+		{
+			return static_cast<uint8_t>(std::clamp(static_cast<int>(std::lround(value * 255.0f)), 0, 255));
+		}
+
+		GLenum GetGLFormat(TextureFormat format)
+		{
+			switch (format)
+			{
+			case TextureFormat::BC1:
+				return GL_COMPRESSED_SRGB_S3TC_DXT1_EXT;
+			case TextureFormat::BC3:
+				return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT;
+			case TextureFormat::BC7:
+				return GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM;
+			default:
+				return GL_SRGB8_ALPHA8;
+			}
+		}
+
+		uint64_t GetLevelSize(TextureFormat format, uint64_t width, uint64_t height)
+		{
+			const uint64_t blocks = ((width + 3) / 4) * ((height + 3) / 4);
+			switch (format)
+			{
+			case TextureFormat::BC1:
+				return blocks * 8;
+			case TextureFormat::BC3:
+			case TextureFormat::BC7:
+				return blocks * 16;
+			default:
+				return width * height * 4;
+			}
+		}
+
+		Image Downsample(const Image& source, JobSystem& jobs)
+		{
+			Image result;
+			result.width = std::max(1u, source.width / 2);
+			result.height = std::max(1u, source.height / 2);
+			result.pixels.resize(size_t(result.width) * result.height * 4);
+
+			jobs.ParallelFor(result.height, [&](unsigned int y) {
+				const unsigned int y0 = std::min(y * 2, source.height - 1);
+				const unsigned int y1 = std::min(y * 2 + 1, source.height - 1);
+				for (unsigned int x = 0; x < result.width; x++)
+				{
+					const unsigned int x0 = std::min(x * 2, source.width - 1);
+					const unsigned int x1 = std::min(x * 2 + 1, source.width - 1);
+					for (unsigned int c = 0; c < 4; c++)
+					{
+						const float sum =
+							source.pixels[(size_t(y0) * source.width + x0) * 4 + c] +
+							source.pixels[(size_t(y0) * source.width + x1) * 4 + c] +
+							source.pixels[(size_t(y1) * source.width + x0) * 4 + c] +
+							source.pixels[(size_t(y1) * source.width + x1) * 4 + c];
+						result.pixels[(size_t(y) * result.width + x) * 4 + c] = sum * 0.25f;
+					}
+				}
+				});
+			return result;
+		}
+
+		void LoadBlock(const std::vector<uint8_t>& rgba, unsigned int width, unsigned int height, unsigned int bx, unsigned int by, uint8_t block[16][4])
+		{
+			for (unsigned int y = 0; y < 4; y++)
+			{
+				for (unsigned int x = 0; x < 4; x++)
+				{
+					const unsigned int sx = std::min(bx * 4 + x, width - 1);
+					const unsigned int sy = std::min(by * 4 + y, height - 1);
+					memcpy(block[y * 4 + x], &rgba[(size_t(sy) * width + sx) * 4], 4);
+				}
+			}
+		}
+
+		// Fits a line through the first N channels of the block (principal axis by power iteration),
+		// and returns its extent over the block as two endpoints.
+		template <int N>
+		void FitEndpoints(const uint8_t block[16][4], float e0[4], float e1[4])
+		{
+			float mean[N] = {};
+			for (int p = 0; p < 16; p++)
+			{
+				for (int c = 0; c < N; c++)
+				{
+					mean[c] += block[p][c] / 16.0f;
+				}
+			}
+
+			float cov[N][N] = {};
+			for (int p = 0; p < 16; p++)
+			{
+				float d[N];
+				for (int c = 0; c < N; c++)
+				{
+					d[c] = block[p][c] - mean[c];
+				}
+				for (int i = 0; i < N; i++)
+				{
+					for (int j = 0; j < N; j++)
+					{
+						cov[i][j] += d[i] * d[j];
+					}
+				}
+			}
+
+			int largest = 0;
+			for (int c = 1; c < N; c++)
+			{
+				if (cov[c][c] > cov[largest][largest])
+				{
+					largest = c;
+				}
+			}
+
+			float axis[N];
+			for (int c = 0; c < N; c++)
+			{
+				axis[c] = cov[c][largest];
+			}
+			for (int iteration = 0; iteration < 8; iteration++)
+			{
+				float next[N] = {};
+				float length = 0.0f;
+				for (int i = 0; i < N; i++)
+				{
+					for (int j = 0; j < N; j++)
+					{
+						next[i] += cov[i][j] * axis[j];
+					}
+					length += next[i] * next[i];
+				}
+				length = std::sqrt(length);
+				for (int c = 0; c < N; c++)
+				{
+					axis[c] = length > 1e-6f ? next[c] / length : 0.0f;
+				}
+			}
+
+			float tMin = 0.0f;
+			float tMax = 0.0f;
+			for (int p = 0; p < 16; p++)
+			{
+				float t = 0.0f;
+				for (int c = 0; c < N; c++)
+				{
+					t += (block[p][c] - mean[c]) * axis[c];
+				}
+				tMin = std::min(tMin, t);
+				tMax = std::max(tMax, t);
+			}
+
+			for (int c = 0; c < 4; c++)
+			{
+				e0[c] = (c < N) ? std::clamp(mean[c] + axis[c] * tMin, 0.0f, 255.0f) : 255.0f;
+				e1[c] = (c < N) ? std::clamp(mean[c] + axis[c] * tMax, 0.0f, 255.0f) : 255.0f;
+			}
+		}
+
+		uint16_t To565(const float color[4])
+		{
+			const int r = std::clamp(static_cast<int>(std::lround(color[0] * 31.0f / 255.0f)), 0, 31);
+			const int g = std::clamp(static_cast<int>(std::lround(color[1] * 63.0f / 255.0f)), 0, 63);
+			const int b = std::clamp(static_cast<int>(std::lround(color[2] * 31.0f / 255.0f)), 0, 31);
+			return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+		}
+
+		void From565(uint16_t value, int color[3])
+		{
+			const int r = value >> 11;
+			const int g = (value >> 5) & 63;
+			const int b = value & 31;
+			color[0] = (r << 3) | (r >> 2);
+			color[1] = (g << 2) | (g >> 4);
+			color[2] = (b << 3) | (b >> 2);
+		}
+
+		void EncodeBC1Color(const uint8_t block[16][4], uint8_t* out)
+		{
+			float e0[4], e1[4];
+			FitEndpoints<3>(block, e0, e1);
+
+			// c0 > c1 selects the four color mode
+			uint16_t c0 = To565(e1);
+			uint16_t c1 = To565(e0);
+			if (c0 < c1)
+			{
+				std::swap(c0, c1);
+			}
+
+			int palette[4][3];
+			From565(c0, palette[0]);
+			From565(c1, palette[1]);
+			for (int c = 0; c < 3; c++)
+			{
+				palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+				palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+			}
+
+			uint32_t indices = 0;
+			if (c0 != c1)
+			{
+				for (int p = 0; p < 16; p++)
+				{
+					int best = 0;
+					int bestError = INT_MAX;
+					for (int i = 0; i < 4; i++)
+					{
+						int error = 0;
+						for (int c = 0; c < 3; c++)
+						{
+							const int d = block[p][c] - palette[i][c];
+							error += d * d;
+						}
+						if (error < bestError)
+						{
+							bestError = error;
+							best = i;
+						}
+					}
+					indices |= uint32_t(best) << (2 * p);
+				}
+			}
+
+			out[0] = c0 & 0xff;
+			out[1] = c0 >> 8;
+			out[2] = c1 & 0xff;
+			out[3] = c1 >> 8;
+			for (int i = 0; i < 4; i++)
+			{
+				out[4 + i] = (indices >> (8 * i)) & 0xff;
+			}
+		}
+
+		void EncodeBC3Alpha(const uint8_t block[16][4], uint8_t* out)
+		{
+			int a0 = 0;
+			int a1 = 255;
+			for (int p = 0; p < 16; p++)
+			{
+				a0 = std::max(a0, int(block[p][3]));
+				a1 = std::min(a1, int(block[p][3]));
+			}
+
+			// a0 > a1 selects eight interpolated values: code 0 is a0, code 1 is a1, codes 2-7 step from a0 to a1.
+			uint64_t indices = 0;
+			if (a0 > a1)
+			{
+				for (int p = 0; p < 16; p++)
+				{
+					const int position = static_cast<int>(std::lround((block[p][3] - a1) * 7.0f / (a0 - a1)));
+					const uint64_t code = (position == 7) ? 0 : (position == 0) ? 1 : 8 - position;
+					indices |= code << (3 * p);
+				}
+			}
+
+			out[0] = static_cast<uint8_t>(a0);
+			out[1] = static_cast<uint8_t>(a1);
+			for (int i = 0; i < 6; i++)
+			{
+				out[2 + i] = (indices >> (8 * i)) & 0xff;
+			}
+		}
+
+		void PutBits(uint8_t* out, unsigned int& position, uint32_t value, unsigned int count)
+		{
+			for (unsigned int i = 0; i < count; i++, position++)
+			{
+				if ((value >> i) & 1)
+				{
+					out[position >> 3] |= 1 << (position & 7);
+				}
+			}
+		}
+
+		// BC7 mode 6 only: one subset, RGBA endpoints with 7 bits plus a p-bit, 4-bit indices.
+		// It handles alpha and smooth gradients well, which covers most of our material textures.
+		void EncodeBC7(const uint8_t block[16][4], uint8_t* out)
+		{
+			static const int k_weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+			float e[2][4];
+			FitEndpoints<4>(block, e[0], e[1]);
+
+			int quantized[2][4];
+			int pBits[2];
+			for (int k = 0; k < 2; k++)
+			{
+				float bestError = FLT_MAX;
+				for (int p = 0; p < 2; p++)
+				{
+					int q[4];
+					float error = 0.0f;
+					for (int c = 0; c < 4; c++)
+					{
+						q[c] = std::clamp(static_cast<int>(std::lround((e[k][c] - p) / 2.0f)), 0, 127);
+						const float d = float((q[c] << 1) | p) - e[k][c];
+						error += d * d;
+					}
+					if (error < bestError)
+					{
+						bestError = error;
+						pBits[k] = p;
+						memcpy(quantized[k], q, sizeof(q));
+					}
+				}
+			}
+
+			int palette[16][4];
+			for (int i = 0; i < 16; i++)
+			{
+				for (int c = 0; c < 4; c++)
+				{
+					const int v0 = (quantized[0][c] << 1) | pBits[0];
+					const int v1 = (quantized[1][c] << 1) | pBits[1];
+					palette[i][c] = ((64 - k_weights[i]) * v0 + k_weights[i] * v1 + 32) >> 6;
+				}
+			}
+
+			int indices[16];
+			for (int p = 0; p < 16; p++)
+			{
+				int bestError = INT_MAX;
+				for (int i = 0; i < 16; i++)
+				{
+					int error = 0;
+					for (int c = 0; c < 4; c++)
+					{
+						const int d = block[p][c] - palette[i][c];
+						error += d * d;
+					}
+					if (error < bestError)
+					{
+						bestError = error;
+						indices[p] = i;
+					}
+				}
+			}
+
+			// The anchor index is stored without its high bit; swapping the endpoints mirrors the (symmetric) weights.
+			if (indices[0] & 8)
+			{
+				std::swap(quantized[0], quantized[1]);
+				std::swap(pBits[0], pBits[1]);
+				for (int p = 0; p < 16; p++)
+				{
+					indices[p] = 15 - indices[p];
+				}
+			}
+
+			memset(out, 0, 16);
+			unsigned int position = 0;
+			PutBits(out, position, 1 << 6, 7);
+			for (int c = 0; c < 4; c++)
+			{
+				PutBits(out, position, quantized[0][c], 7);
+				PutBits(out, position, quantized[1][c], 7);
+			}
+			PutBits(out, position, pBits[0], 1);
+			PutBits(out, position, pBits[1], 1);
+			PutBits(out, position, indices[0], 3);
+			for (int p = 1; p < 16; p++)
+			{
+				PutBits(out, position, indices[p], 4);
+			}
+		}
+
+		void EncodeLevel(const Image& level, TextureFormat format, JobSystem& jobs, unsigned char* out)
+		{
+			std::vector<uint8_t> rgba(size_t(level.width) * level.height * 4);
+			jobs.ParallelFor(level.height, [&](unsigned int y) {
+				for (size_t i = size_t(y) * level.width * 4; i < size_t(y + 1) * level.width * 4; i++)
+				{
+					const bool alpha = (i % 4) == 3;
+					rgba[i] = ToByte(alpha ? level.pixels[i] : LinearToSrgb(level.pixels[i]));
+				}
+				});
+
+			if (format == TextureFormat::RGBA8)
+			{
+				memcpy(out, rgba.data(), rgba.size());
+				return;
+			}
+
+			const unsigned int blocksX = (level.width + 3) / 4;
+			const unsigned int blocksY = (level.height + 3) / 4;
+			const size_t blockSize = (format == TextureFormat::BC1) ? 8 : 16;
+			jobs.ParallelFor(blocksY, [&](unsigned int by) {
+				uint8_t block[16][4];
+				for (unsigned int bx = 0; bx < blocksX; bx++)
+				{
+					LoadBlock(rgba, level.width, level.height, bx, by, block);
+					unsigned char* blockOut = out + (size_t(by) * blocksX + bx) * blockSize;
+					switch (format)
+					{
+					case TextureFormat::BC1:
+						EncodeBC1Color(block, blockOut);
+						break;
+					case TextureFormat::BC3:
+						EncodeBC3Alpha(block, blockOut);
+						EncodeBC1Color(block, blockOut + 8);
+						break;
+					default:
+						EncodeBC7(block, blockOut);
+						break;
+					}
+				}
+				});
+		}
+
+		// Reads the levels of a cooked texture laid out in memory; data pointers refer to base.
+		std::optional<CookedTexture> Parse(const unsigned char* base, size_t size, TextureFormat requestedFormat)
+		{
+			if (size < sizeof(Header))
+			{
+				return {};
+			}
+
+			Header header;
+			memcpy(&header, base, sizeof(Header));
+			if (header.magic != k_magic || header.version != k_version || header.requestedFormat != uint32_t(requestedFormat) ||
+				header.levelCount == 0 || header.levelCount > k_maxLevels ||
+				sizeof(Header) + header.levelCount * sizeof(LevelEntry) > size)
+			{
+				return {};
+			}
+
+			CookedTexture result;
+			result.format = static_cast<TextureFormat>(header.format);
+			result.glInternalFormat = header.glInternalFormat;
+
+			for (uint32_t i = 0; i < header.levelCount; i++)
+			{
+				LevelEntry entry;
+				memcpy(&entry, base + sizeof(Header) + i * sizeof(LevelEntry), sizeof(LevelEntry));
+				if (entry.offset > size || entry.size > size - entry.offset ||
+					entry.size != GetLevelSize(result.format, entry.width, entry.height))
+				{
+					return {};
+				}
+
+				TextureLevel level;
+				level.width = entry.width;
+				level.height = entry.height;
+				level.data = base + entry.offset;
+				level.size = static_cast<size_t>(entry.size);
+				result.levels.push_back(level);
+			}
+			return result;
+		}
+	}
+
+	std::optional<CookedTexture> TextureCooker::Load(const std::string& sourcePath, TextureFormat format)
+	{
+		namespace fs = std::filesystem;
+
+		const std::string cookedPath = CookedPath(sourcePath);
+		std::error_code error;
+		const auto cookedTime = fs::last_write_time(cookedPath, error);
+		if (error)
+		{
+			return {};
+		}
+		const auto sourceTime = fs::last_write_time(sourcePath, error);
+		if (error || cookedTime < sourceTime)
+		{
+			return {};
+		}
+
+		auto mapping = std::make_shared<MappedFile>(cookedPath);
+		if (!mapping->valid())
+		{
+			return {};
+		}
+
+		std::optional<CookedTexture> result = Parse(mapping->data(), mapping->size(), format);
+		if (!result.has_value())
+		{
+			fmt::print("Warning(TextureCooker): Ignoring outdated or corrupted cooked texture({})\n", cookedPath);
+			return {};
+		}
+		result->mapping = mapping;
+		return result;
+	}
+
+	std::optional<CookedTexture> TextureCooker::Cook(const std::string& sourcePath, TextureFormat format, JobSystem& jobs)
+	{
+		int width, height, numComponents;
+		unsigned char* data = stbi_load(sourcePath.c_str(), &width, &height, &numComponents, 4);
+		if (data == nullptr)
+		{
+			return {};
+		}
+		if (numComponents < 3)
+		{
+			stbi_image_free(data);
+			return {};
+		}
+
+		TextureFormat resolvedFormat = format;
+		if (format == TextureFormat::Auto)
+		{
+			bool opaque = true;
+			for (size_t i = 3; i < size_t(width) * height * 4 && opaque; i += 4)
+			{
+				opaque = data[i] == 255;
+			}
+			resolvedFormat = opaque ? TextureFormat::BC1 : TextureFormat::BC3;
+		}
+
+		// Filter in linear space, so that mips don't darken
+		static const auto k_srgbToLinear = []() {
+			std::vector<float> table(256);
+			for (int i = 0; i < 256; i++)
+			{
+				table[i] = SrgbToLinear(i / 255.0f);
+			}
+			return table;
+		}();
+
+		std::vector<Image> levels(1);
+		levels[0].width = width;
+		levels[0].height = height;
+		levels[0].pixels.resize(size_t(width) * height * 4);
+		jobs.ParallelFor(height, [&](unsigned int y) {
+			for (size_t i = size_t(y) * width * 4; i < size_t(y + 1) * width * 4; i++)
+			{
+				const bool alpha = (i % 4) == 3;
+				levels[0].pixels[i] = alpha ? data[i] / 255.0f : k_srgbToLinear[data[i]];
+			}
+			});
+		stbi_image_free(data);
+
+		while (levels.back().width > 1 || levels.back().height > 1)
+		{
+			levels.push_back(Downsample(levels.back(), jobs));
+		}
+
+		// Lay out the whole file in memory; the result refers into it, and it is written out as-is.
+		Header header{};
+		header.magic = k_magic;
+		header.version = k_version;
+		header.requestedFormat = static_cast<uint32_t>(format);
+		header.format = static_cast<uint32_t>(resolvedFormat);
+		header.glInternalFormat = GetGLFormat(resolvedFormat);
+		header.width = width;
+		header.height = height;
+		header.levelCount = static_cast<uint32_t>(levels.size());
+
+		std::vector<LevelEntry> entries(levels.size());
+		uint64_t offset = Align(sizeof(Header) + entries.size() * sizeof(LevelEntry));
+		for (size_t i = 0; i < levels.size(); i++)
+		{
+			entries[i].width = levels[i].width;
+			entries[i].height = levels[i].height;
+			entries[i].size = GetLevelSize(resolvedFormat, levels[i].width, levels[i].height);
+			entries[i].offset = offset;
+			offset = Align(offset + entries[i].size);
+		}
+
+		std::vector<unsigned char> storage(offset, 0);
+		memcpy(storage.data(), &header, sizeof(Header));
+		memcpy(storage.data() + sizeof(Header), entries.data(), entries.size() * sizeof(LevelEntry));
+		for (size_t i = 0; i < levels.size(); i++)
+		{
+			EncodeLevel(levels[i], resolvedFormat, jobs, storage.data() + entries[i].offset);
+		}
+
+		const std::string cookedPath = CookedPath(sourcePath);
+		const std::string tempPath = MappedFile::TempPath(cookedPath);
+		bool written = false;
+		{
+			std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+			file.write(reinterpret_cast<const char*>(storage.data()), static_cast<std::streamsize>(storage.size()));
+			written = static_cast<bool>(file);
+		}
+		if (!written)
+		{
+			fmt::print("Warning(TextureCooker): Failed to write cooked texture({})\n", cookedPath);
+			std::error_code error;
+			std::filesystem::remove(tempPath, error);
+		}
+		else if (const std::error_code error = MappedFile::Replace(tempPath, cookedPath))
+		{
+			// On Windows, while the cooked file is mapped, e.g. by another run loading it; this run uses the texture
+			// cooked in memory, and a stale file cooks again on its next load
+			fmt::print("Warning(TextureCooker): Cannot replace cooked texture({}), keeping the existing one: {}\n", cookedPath, error.message());
+		}
+
+		std::optional<CookedTexture> result = Parse(storage.data(), storage.size(), format);
+		result->storage = std::move(storage);
+		return result;
+	}
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <optional>
+#include <memory>
+#include <cstdint>
+
+#include <glad/glad.h>
+
+#include "MappedFile.h"
+#include "JobSystem.h"
+
+// S3TC formats come from EXT_texture_compression_s3tc / EXT_texture_sRGB, which our core-profile glad does not expose.
+#ifndef GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_SRGB_S3TC_DXT1_EXT 0x8C4C
+#endif
+#ifndef GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+#endif
+
+namespace sparkle
+{
+	enum class TextureFormat : uint32_t
+	{
+		Auto, // BC1 for opaque images, BC3 otherwise
+		RGBA8, // Uncompressed
+		BC1,
+		BC3,
+		BC7,
+	};
+
+	struct TextureLevel
+	{
+		unsigned int width = 0;
+		unsigned int height = 0;
+		const unsigned char* data = nullptr;
+		size_t size = 0;
+	};
+
+	// A full mip chain in its GPU format, either read from a cooked file or freshly cooked.
+	struct CookedTexture
+	{
+		TextureFormat format = TextureFormat::RGBA8; // Never Auto
+		GLenum glInternalFormat = GL_SRGB8_ALPHA8;
+		std::vector<TextureLevel> levels;
+
+		// Owner of the level data. Moving keeps the level pointers valid, copying would not.
+		std::shared_ptr<MappedFile> mapping;
+		std::vector<unsigned char> storage;
+
+		CookedTexture() = default;
+		CookedTexture(CookedTexture&&) = default;
+		CookedTexture& operator=(CookedTexture&&) = default;
+		CookedTexture(const CookedTexture&) = delete;
+		CookedTexture& operator=(const CookedTexture&) = delete;
+
+		bool compressed() const
+		{
+			return format != TextureFormat::RGBA8;
+		}
+	};
+
+	// Turns RGB(A) images into sRGB texture containers with a precomputed mip chain, block-compressed to BC1/BC3/BC7.
+	// Loading a cooked texture is a memory mapping; nothing is decoded and no mipmaps are generated on the GL thread.
+	//
+	// File layout (<source>.sptx, little endian, modeled after KTX2):
+	//   Header | Level index (largest level first) | 16-byte aligned level data
+	class TextureCooker
+	{
+	public:
+		/// <summary>
+		/// Maps the cooked file of sourcePath if it exists, is at least as new as sourcePath,
+		/// and was cooked for the requested format.
+		/// </summary>
+		/// <returns>An empty optional if there is no usable cooked file</returns>
+		static std::optional<CookedTexture> Load(const std::string& sourcePath, TextureFormat format);
+
+		/// <summary>
+		/// Decodes sourcePath, builds its sRGB-correct mip chain, encodes it in parallel on jobs
+		/// and writes the cooked file. Images with fewer than three channels are not cooked.
+		/// </summary>
+		/// <returns>The cooked texture, also when writing the file failed; an empty optional if the image can't be cooked</returns>
+		static std::optional<CookedTexture> Cook(const std::string& sourcePath, TextureFormat format, JobSystem& jobs);
+
+		static std::string CookedPath(const std::string& sourcePath)
+		{
+			return sourcePath + ".sptx";
+		}
+	};
+}
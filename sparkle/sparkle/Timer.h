@@ -9,6 +9,8 @@
 #include <fmt/printf.h>
 #include <cuda_runtime.h>
 
+#include "Global.h"
+
 namespace sparkle
 {
 	class Timer
@@ -19,7 +21,6 @@ namespace sparkle
 			s_timer = this;
 
 			m_lastUpdateTime = (float)CurrentTime();
-			m_fixedUpdateTimer = (float)CurrentTime();
 		}
 
 		~Timer()
@@ -143,30 +144,67 @@ namespace sparkle
 		static void UpdateDeltaTime()
 		{
 			float current = (float)CurrentTime();
-			s_timer->m_deltaTime = std::min(current - s_timer->m_lastUpdateTime, 0.2f);
+			if (s_timer->m_deltaTimeOverride >= 0.0f)
+			{
+				s_timer->m_deltaTime = s_timer->m_deltaTimeOverride;
+				s_timer->m_deltaTimeOverride = -1.0f;
+			}
+			else
+			{
+				s_timer->m_deltaTime = s_timer->m_simulatedTime ? s_timer->m_fixedDeltaTime : std::min(current - s_timer->m_lastUpdateTime, 0.2f);
+			}
 			s_timer->m_lastUpdateTime = current;
 		}
 
+		// The next UpdateDeltaTime() takes deltaTime instead of measuring it, e.g. to replay a recorded frame.
+		static void OverrideDeltaTime(float deltaTime)
+		{
+			s_timer->m_deltaTimeOverride = deltaTime;
+		}
+
+		// With simulated time every frame advances exactly one fixed step, however long it actually took.
+		static void UseSimulatedTime(bool simulated)
+		{
+			s_timer->m_simulatedTime = simulated;
+		}
+
 		static void NextFrame()
 		{
 			s_timer->m_frameCount++;
 			s_timer->m_elapsedTime += s_timer->m_deltaTime;
+
+			// Time the simulation can't catch up on is dropped, so slow frames slow down the simulation
+			// instead of making the next frame even slower
+			const double maxAccumulated = Global::Config::maxFixedStepsPerFrame * (double)s_timer->m_fixedDeltaTime;
+			s_timer->m_fixedAccumulator = std::min(s_timer->m_fixedAccumulator + s_timer->m_deltaTime, maxAccumulated);
 		}
 
-		// return true when fixed update should be executed
+		/// <summary>
+		/// Returns true while a fixed update is due, consuming one fixed step of the frame time each call:
+		/// <code>while (Timer::NextFixedFrame()) { ... }</code>
+		/// Leftover time carries over to the next frame, so the simulation advances fixedDeltaTime() per step
+		/// at any frame rate.
+		/// </summary>
 		static bool NextFixedFrame()
 		{
-			s_timer->m_fixedUpdateTimer += s_timer->m_deltaTime;
-
-			if (s_timer->m_fixedUpdateTimer > s_timer->m_fixedDeltaTime)
+			if (s_timer->m_fixedAccumulator >= s_timer->m_fixedDeltaTime)
 			{
-				s_timer->m_fixedUpdateTimer = 0;
+				s_timer->m_fixedAccumulator -= s_timer->m_fixedDeltaTime;
 				s_timer->m_physicsFrameCount++;
 				return true;
 			}
 			return false;
 		}
 
+		// How far the current frame is between the last fixed step and the next one, in [0, 1].
+		// Rendering blends the last two fixed states by it (see Transform::SetInterpolated).
+		// Clamped, as stepping a paused game stops after one fixed step with a full step or more still accumulated;
+		// the stepped frame then shows its latest fixed state instead of extrapolating past it.
+		static float fixedAlpha()
+		{
+			return (float)std::min(s_timer->m_fixedAccumulator / s_timer->m_fixedDeltaTime, 1.0);
+		}
+
 		static bool PeriodicUpdate(const std::string& label, float interval, bool allowRepetition = true)
 		{
 			auto& l2t = s_timer->label2accumulatedTime;
@@ -224,7 +262,11 @@ namespace sparkle
 		const float m_fixedDeltaTime = 1.0f / 60.0f;
 
 		float m_lastUpdateTime = 0.0f;
-		float m_fixedUpdateTimer = 0.0f;
+		bool m_simulatedTime = false;
+		// Used by the next UpdateDeltaTime() if not negative
+		float m_deltaTimeOverride = -1.0f;
+		// Frame time not yet consumed by fixed steps
+		double m_fixedAccumulator = 0.0;
 	};
 
 	class ScopedTimerGPU
@@ -0,0 +1,405 @@
+#include "Transform.h"
+
+#include <mutex>
+#include <algorithm>
+
+#include "fmt/core.h"
+
+#include "Global.h"
+#include "JobSystem.h"
+
+namespace sparkle
+{
+	namespace
+	{
+		enum DirtyFlags : uint8_t
+		{
+			k_localDirty = 1,
+			k_worldDirty = 2,
+			// Not dirty; set for transforms blending between fixed steps
+			k_interpolated = 4,
+		};
+
+		const uint8_t k_dirty = k_localDirty | k_worldDirty;
+
+		const unsigned int k_transformsPerJob = 512;
+
+		// Structure of arrays indexed by Transform::m_index, so the per-frame pass streams through tightly packed data.
+		struct TransformStore
+		{
+			std::vector<glm::vec3> positions;
+			std::vector<glm::quat> rotations;
+			std::vector<glm::vec3> scales;
+			std::vector<int> parents;
+			// Number of ancestors; transforms of equal depth never depend on each other
+			std::vector<unsigned int> depths;
+			std::vector<uint8_t> flags;
+
+			std::vector<glm::mat4> localMatrices;
+			std::vector<glm::mat4> worldMatrices;
+			std::vector<glm::mat3> normalMatrices;
+			std::vector<unsigned int> versions;
+
+			// Values as of the previous fixed step, for interpolated transforms only
+			std::vector<glm::vec3> previousPositions;
+			std::vector<glm::quat> previousRotations;
+			std::vector<glm::vec3> previousScales;
+			std::vector<Transform*> interpolated;
+			float alpha = 1.0f;
+
+			// Indices which became dirty since the last UpdateMatrices(); may contain freed or already updated ones
+			std::vector<unsigned int> dirty;
+			std::vector<unsigned int> freeIndices;
+			// Guards dirty and flags while parallel updates move their transforms
+			std::mutex mutex;
+		};
+
+		TransformStore& Store()
+		{
+			static TransformStore store;
+			return store;
+		}
+
+		// Expects the parent to be up to date.
+		void Recompute(TransformStore& s, unsigned int i)
+		{
+			if (s.flags[i] & k_localDirty)
+			{
+				glm::vec3 position = s.positions[i];
+				glm::quat rotation = s.rotations[i];
+				glm::vec3 scale = s.scales[i];
+				if (s.flags[i] & k_interpolated)
+				{
+					position = glm::mix(s.previousPositions[i], position, s.alpha);
+					rotation = glm::slerp(s.previousRotations[i], rotation, s.alpha);
+					scale = glm::mix(s.previousScales[i], scale, s.alpha);
+				}
+
+				// Translate * rotate * scale, without multiplying full matrices
+				const glm::mat3 rotationMatrix = glm::mat3_cast(rotation);
+				glm::mat4& local = s.localMatrices[i];
+				local[0] = glm::vec4(rotationMatrix[0] * scale.x, 0.0f);
+				local[1] = glm::vec4(rotationMatrix[1] * scale.y, 0.0f);
+				local[2] = glm::vec4(rotationMatrix[2] * scale.z, 0.0f);
+				local[3] = glm::vec4(position, 1.0f);
+			}
+			const int parent = s.parents[i];
+			s.worldMatrices[i] = (parent >= 0) ? s.worldMatrices[parent] * s.localMatrices[i] : s.localMatrices[i];
+			s.normalMatrices[i] = glm::transpose(glm::inverse(glm::mat3(s.worldMatrices[i])));
+			s.versions[i]++;
+			s.flags[i] &= k_interpolated;
+		}
+
+		bool MovedSinceFixedStep(const TransformStore& s, unsigned int i)
+		{
+			return s.positions[i] != s.previousPositions[i] || s.rotations[i] != s.previousRotations[i] || s.scales[i] != s.previousScales[i];
+		}
+	}
+
+	Transform::Transform(Actor* actor) : m_actor(actor)
+	{
+		auto& s = Store();
+		std::lock_guard<std::mutex> lock(s.mutex);
+		if (!s.freeIndices.empty())
+		{
+			m_index = s.freeIndices.back();
+			s.freeIndices.pop_back();
+		}
+		else
+		{
+			m_index = static_cast<unsigned int>(s.positions.size());
+			s.positions.emplace_back();
+			s.rotations.emplace_back();
+			s.scales.emplace_back();
+			s.parents.emplace_back();
+			s.depths.emplace_back();
+			s.flags.emplace_back();
+			s.localMatrices.emplace_back();
+			s.worldMatrices.emplace_back();
+			s.normalMatrices.emplace_back();
+			s.versions.emplace_back();
+			s.previousPositions.emplace_back();
+			s.previousRotations.emplace_back();
+			s.previousScales.emplace_back();
+		}
+
+		s.positions[m_index] = glm::vec3(0.0f);
+		s.rotations[m_index] = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+		s.scales[m_index] = glm::vec3(1.0f);
+		s.parents[m_index] = -1;
+		s.depths[m_index] = 0;
+		s.localMatrices[m_index] = glm::mat4(1.0f);
+		s.worldMatrices[m_index] = glm::mat4(1.0f);
+		s.normalMatrices[m_index] = glm::mat3(1.0f);
+		s.versions[m_index]++;
+		s.flags[m_index] = 0;
+	}
+
+	Transform::~Transform()
+	{
+		for (auto child : std::vector<Transform*>(m_children))
+		{
+			child->SetParent(nullptr);
+		}
+		SetParent(nullptr);
+		SetInterpolated(false);
+
+		auto& s = Store();
+		std::lock_guard<std::mutex> lock(s.mutex);
+		s.flags[m_index] = 0;
+		s.freeIndices.push_back(m_index);
+	}
+
+	glm::vec3 Transform::position() const
+	{
+		return Store().positions[m_index];
+	}
+
+	glm::quat Transform::rotation() const
+	{
+		return Store().rotations[m_index];
+	}
+
+	glm::vec3 Transform::scale() const
+	{
+		return Store().scales[m_index];
+	}
+
+	void Transform::SetPosition(const glm::vec3& position)
+	{
+		Store().positions[m_index] = position;
+		MarkDirty(true);
+	}
+
+	void Transform::SetRotation(const glm::quat& rotation)
+	{
+		Store().rotations[m_index] = glm::normalize(rotation);
+		MarkDirty(true);
+	}
+
+	void Transform::SetScale(const glm::vec3& scale)
+	{
+		Store().scales[m_index] = scale;
+		MarkDirty(true);
+	}
+
+	glm::vec3 Transform::eulerAngles() const
+	{
+		return utils::QuatToEuler(rotation());
+	}
+
+	void Transform::SetEulerAngles(const glm::vec3& degrees)
+	{
+		SetRotation(utils::EulerToQuat(degrees));
+	}
+
+	void Transform::Reset()
+	{
+		auto& s = Store();
+		s.positions[m_index] = glm::vec3(0.0f);
+		s.rotations[m_index] = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+		s.scales[m_index] = glm::vec3(1.0f);
+		MarkDirty(true);
+	}
+
+	glm::mat4 Transform::localMatrix()
+	{
+		UpdateNow();
+		return Store().localMatrices[m_index];
+	}
+
+	glm::mat4 Transform::matrix()
+	{
+		UpdateNow();
+		return Store().worldMatrices[m_index];
+	}
+
+	glm::mat3 Transform::normalMatrix()
+	{
+		UpdateNow();
+		return Store().normalMatrices[m_index];
+	}
+
+	glm::vec3 Transform::worldPosition()
+	{
+		UpdateNow();
+		return glm::vec3(Store().worldMatrices[m_index][3]);
+	}
+
+	unsigned int Transform::version()
+	{
+		UpdateNow();
+		return Store().versions[m_index];
+	}
+
+	void Transform::SetParent(Transform* parent)
+	{
+		if (parent == m_parent)
+		{
+			return;
+		}
+		for (auto ancestor = parent; ancestor != nullptr; ancestor = ancestor->m_parent)
+		{
+			if (ancestor == this)
+			{
+				fmt::print("Error(Transform): Cannot attach a transform to its own descendant.\n");
+				return;
+			}
+		}
+
+		if (m_parent)
+		{
+			auto& siblings = m_parent->m_children;
+			siblings.erase(std::find(siblings.begin(), siblings.end(), this));
+		}
+		m_parent = parent;
+		if (m_parent)
+		{
+			m_parent->m_children.push_back(this);
+		}
+
+		Store().parents[m_index] = m_parent ? static_cast<int>(m_parent->m_index) : -1;
+		UpdateDepth();
+		MarkDirty(false);
+	}
+
+	void Transform::SetInterpolated(bool interpolated)
+	{
+		auto& s = Store();
+		auto position = std::find(s.interpolated.begin(), s.interpolated.end(), this);
+		if (interpolated == (position != s.interpolated.end()))
+		{
+			return;
+		}
+
+		if (interpolated)
+		{
+			s.interpolated.push_back(this);
+			s.previousPositions[m_index] = s.positions[m_index];
+			s.previousRotations[m_index] = s.rotations[m_index];
+			s.previousScales[m_index] = s.scales[m_index];
+			s.flags[m_index] |= k_interpolated;
+		}
+		else
+		{
+			s.interpolated.erase(position);
+			s.flags[m_index] &= ~k_interpolated;
+		}
+		MarkDirty(true);
+	}
+
+	void Transform::UpdateMatrices(float alpha)
+	{
+		auto& s = Store();
+		s.alpha = alpha;
+		// Interpolated transforms that moved during the last fixed step change every frame until the next one
+		for (auto transform : s.interpolated)
+		{
+			if (MovedSinceFixedStep(s, transform->m_index))
+			{
+				transform->MarkDirty(true);
+			}
+		}
+		if (s.dirty.empty())
+		{
+			return;
+		}
+
+		// Parents first; duplicates come from indices freed and reused while dirty
+		std::sort(s.dirty.begin(), s.dirty.end(), [&s](unsigned int a, unsigned int b) {
+			return s.depths[a] != s.depths[b] ? s.depths[a] < s.depths[b] : a < b;
+			});
+		s.dirty.erase(std::unique(s.dirty.begin(), s.dirty.end()), s.dirty.end());
+
+		// Each depth level only reads the level above, so its transforms can be updated in parallel
+		size_t begin = 0;
+		while (begin < s.dirty.size())
+		{
+			const unsigned int depth = s.depths[s.dirty[begin]];
+			size_t end = begin;
+			while (end < s.dirty.size() && s.depths[s.dirty[end]] == depth)
+			{
+				end++;
+			}
+
+			const unsigned int* indices = s.dirty.data() + begin;
+			Global::jobs->ParallelFor(static_cast<unsigned int>(end - begin), [&s, indices](unsigned int i) {
+				if (s.flags[indices[i]] & k_dirty)
+				{
+					Recompute(s, indices[i]);
+				}
+				}, k_transformsPerJob);
+			begin = end;
+		}
+		s.dirty.clear();
+	}
+
+	void Transform::SaveFixedState()
+	{
+		auto& s = Store();
+		for (auto transform : s.interpolated)
+		{
+			const unsigned int i = transform->m_index;
+			if (!MovedSinceFixedStep(s, i))
+			{
+				continue;
+			}
+			s.previousPositions[i] = s.positions[i];
+			s.previousRotations[i] = s.rotations[i];
+			s.previousScales[i] = s.scales[i];
+			// The matrices still show a blend, and must settle on the values even if they don't change again
+			transform->MarkDirty(true);
+		}
+	}
+
+	void Transform::MarkDirty(bool localChanged)
+	{
+		auto& s = Store();
+		std::lock_guard<std::mutex> lock(s.mutex);
+
+		// A transform whose world matrix is dirty already has all of its descendants marked
+		std::vector<Transform*> stack = { this };
+		while (!stack.empty())
+		{
+			Transform* current = stack.back();
+			stack.pop_back();
+
+			uint8_t& flags = s.flags[current->m_index];
+			const bool descendantsDirty = (flags & k_worldDirty) != 0;
+			if ((flags & k_dirty) == 0)
+			{
+				s.dirty.push_back(current->m_index);
+			}
+			flags |= k_worldDirty | ((current == this && localChanged) ? k_localDirty : 0);
+
+			if (!descendantsDirty)
+			{
+				stack.insert(stack.end(), current->m_children.begin(), current->m_children.end());
+			}
+		}
+	}
+
+	void Transform::UpdateDepth()
+	{
+		auto& s = Store();
+		s.depths[m_index] = m_parent ? s.depths[m_parent->m_index] + 1 : 0;
+		for (auto child : m_children)
+		{
+			child->UpdateDepth();
+		}
+	}
+
+	void Transform::UpdateNow()
+	{
+		auto& s = Store();
+		if ((s.flags[m_index] & k_dirty) == 0)
+		{
+			return;
+		}
+		if (m_parent)
+		{
+			m_parent->UpdateNow();
+		}
+		Recompute(s, m_index);
+	}
+}
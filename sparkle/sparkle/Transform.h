@@ -1,8 +1,11 @@
 #pragma once
 
+#include <vector>
+
 #include <glm.hpp>
 #include <gtc/matrix_transform.hpp>
 #include <gtc/type_ptr.hpp>
+#include <gtc/quaternion.hpp>
 
 #include "utils.h"
 
@@ -10,32 +13,87 @@ namespace sparkle
 {
 	class Actor;
 
+	// Position, rotation and scale relative to the parent transform, or to the world without one.
+	//
+	// The values and matrices of all transforms are stored in shared arrays (see Transform.cpp).
+	// Changing a transform marks it and all of its descendants dirty, and UpdateMatrices() recomputes
+	// every dirty transform in one pass per frame, so transforms that don't move cost nothing.
+	// Reading the matrices of a dirty transform before that updates it (and its dirty ancestors) right away.
+	//
+	// Transforms are created, destroyed and re-parented on the main thread only.
+	// Parallel updates may change their own actor's transform, but must not read matrices of other actors.
 	class Transform
 	{
 	public:
-		Transform(Actor* actor) : m_actor(actor) {};
+		Transform(Actor* actor);
+		Transform(const Transform&) = delete;
+		// Children become roots, keeping their local values.
+		~Transform();
+
+		glm::vec3 position() const;
+		glm::quat rotation() const;
+		glm::vec3 scale() const;
+
+		void SetPosition(const glm::vec3& position);
+		void SetRotation(const glm::quat& rotation);
+		void SetScale(const glm::vec3& scale);
+
+		// Rotation as Euler angles in degrees, applied in Y, Z, X order (see utils::EulerToQuat)
+		glm::vec3 eulerAngles() const;
+		void SetEulerAngles(const glm::vec3& degrees);
+
+		void Reset();
+
+		// Local space to parent space
+		glm::mat4 localMatrix();
+
+		// Local space to world space
+		glm::mat4 matrix();
+
+		// Transforms normals from local space to world space, i.e. the inverse transpose of matrix()
+		glm::mat3 normalMatrix();
 
-		glm::mat4 matrix()
-		{
-			glm::mat4 result = glm::mat4(1.0f);
-			result = glm::translate(result, position);
-			result = utils::RotateEuler(result, rotation);
-			result = glm::scale(result, scale);
-			return result;
-		}
+		glm::vec3 worldPosition();
+
+		// Increases whenever the world matrix changes, so dependent values can be cached.
+		unsigned int version();
+
+		Transform* parent() const { return m_parent; }
+
+		const std::vector<Transform*>& children() const { return m_children; }
+
+		/// <summary>
+		/// Attaches this transform to parent, or makes it a root for nullptr.
+		/// The local values are kept, so the transform follows the new parent from where it is relative to it.
+		/// </summary>
+		void SetParent(Transform* parent);
 
 		Actor* actor() { return m_actor; }
 
-		void Reset()
-		{
-			position = glm::vec3(0.0f);
-			rotation = glm::vec3(0.0f);
-			scale = glm::vec3(1.0f);
-		}
+		/// <summary>
+		/// For transforms moved by fixed updates: the matrices blend the values of the last two fixed steps
+		/// by Timer::fixedAlpha(), so motion looks smooth at frame rates other than the fixed rate.
+		/// The matrices then trail the values by less than one fixed step.
+		/// </summary>
+		void SetInterpolated(bool interpolated);
+
+		/// <summary>
+		/// Recomputes the matrices of all transforms changed since the last call, parents before children.
+		/// </summary>
+		/// <param name="alpha">Blend factor for interpolated transforms</param>
+		static void UpdateMatrices(float alpha = 1.0f);
+
+		// Records the values of interpolated transforms as the state before the coming fixed step.
+		static void SaveFixedState();
+
+	private:
+		void MarkDirty(bool localChanged);
+		void UpdateDepth();
+		void UpdateNow();
 
-		glm::vec3 position = glm::vec3(0.0f);
-		glm::vec3 rotation = glm::vec3(0.0f);
-		glm::vec3 scale = glm::vec3(1.0f);
+		unsigned int m_index;
 		Actor* m_actor = nullptr;
+		Transform* m_parent = nullptr;
+		std::vector<Transform*> m_children;
 	};
-}
\ No newline at end of file
+}
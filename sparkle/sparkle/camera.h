@@ -21,36 +21,106 @@ namespace sparkle
 		Camera()
 		{
 			SET_COMPONENT_NAME
+			// Cameras only update their cached matrices when queried, never in Update()
+			threadSafe = true;
 			Global::camera = this;
 		}
 
 		glm::vec3 position() const
 		{
-			return actor->transform->position;
+			UpdateCache();
+			return m_position;
 		}
 
 		glm::vec3 front() const
 		{
-			const glm::vec3 kFront = glm::vec3(0.0f, 0.0f, -1.0f);
-			return utils::RotateEuler(kFront, actor->transform->rotation);
+			UpdateCache();
+			return m_front;
 		}
 
 		glm::vec3 up() const
 		{
-			const glm::vec3 kUp = glm::vec3(0.0f, 1.0f, 0.0f);
-			return utils::RotateEuler(kUp, actor->transform->rotation);
+			UpdateCache();
+			return m_up;
+		}
+
+		glm::vec3 right() const
+		{
+			UpdateCache();
+			return m_right;
 		}
 
 		glm::mat4 view() const
 		{
-			return glm::lookAt(position(), position() + front(), up());
+			UpdateCache();
+			return m_view;
+		}
+
+		glm::mat4 inverseView() const
+		{
+			UpdateCache();
+			return m_inverseView;
 		}
 
 		glm::mat4 projection() const
 		{
-			auto size = Global::game->windowSize();
-			auto screenAspect = (float)size.x / (float)size.y;
-			return glm::perspective(glm::radians(zoom), screenAspect, 0.01f, 100.0f);
+			UpdateCache();
+			return m_projection;
+		}
+
+		glm::mat4 viewProjection() const
+		{
+			UpdateCache();
+			return m_viewProjection;
 		}
+
+	private:
+		// Recomputes the basis and matrices only if the transform, the zoom or the window size changed since the last call.
+		void UpdateCache() const
+		{
+			const unsigned int version = actor->transform->version();
+			const glm::ivec2 size = Global::game->windowSize();
+			const bool moved = version != m_transformVersion;
+			const bool reshaped = size != m_windowSize || zoom != m_zoom;
+			if (!moved && !reshaped)
+			{
+				return;
+			}
+
+			if (moved)
+			{
+				const glm::mat4 world = actor->transform->matrix();
+				m_position = glm::vec3(world[3]);
+				m_front = glm::normalize(glm::mat3(world) * glm::vec3(0.0f, 0.0f, -1.0f));
+				m_up = glm::normalize(glm::mat3(world) * glm::vec3(0.0f, 1.0f, 0.0f));
+				m_right = glm::normalize(glm::cross(m_front, m_up));
+				m_view = glm::lookAt(m_position, m_position + m_front, m_up);
+				m_inverseView = glm::inverse(m_view);
+				m_transformVersion = version;
+			}
+
+			if (reshaped)
+			{
+				const float screenAspect = (size.y > 0) ? (float)size.x / (float)size.y : 1.0f;
+				m_projection = glm::perspective(glm::radians(zoom), screenAspect, 0.01f, 100.0f);
+				m_windowSize = size;
+				m_zoom = zoom;
+			}
+
+			m_viewProjection = m_projection * m_view;
+		}
+
+		mutable unsigned int m_transformVersion = 0;
+		mutable glm::ivec2 m_windowSize = glm::ivec2(-1);
+		mutable float m_zoom = 0.0f;
+
+		mutable glm::vec3 m_position = glm::vec3(0.0f);
+		mutable glm::vec3 m_front = glm::vec3(0.0f, 0.0f, -1.0f);
+		mutable glm::vec3 m_up = glm::vec3(0.0f, 1.0f, 0.0f);
+		mutable glm::vec3 m_right = glm::vec3(1.0f, 0.0f, 0.0f);
+		mutable glm::mat4 m_view = glm::mat4(1.0f);
+		mutable glm::mat4 m_inverseView = glm::mat4(1.0f);
+		mutable glm::mat4 m_projection = glm::mat4(1.0f);
+		mutable glm::mat4 m_viewProjection = glm::mat4(1.0f);
 	};
 }
@@ -1,5 +1,9 @@
 
 #include <iostream>
+#include <string>
+#include <cstdlib>
+#include <cctype>
+#include <algorithm>
 
 #include "SpEngine.h"
 #include "GameInstance.h"
@@ -33,8 +37,8 @@ namespace sparkle
 				auto mesh = Resource::LoadMesh("sphere.obj");
 				auto renderer = std::make_shared<MeshRenderer>(mesh, material, true);
 				sphere->AddComponent(renderer);
-				sphere->transform->position = glm::vec3(0.6f, 2.0f, 0.0f);
-				sphere->transform->scale = glm::vec3(0.5f);
+				sphere->transform->SetPosition(glm::vec3(0.6f, 2.0f, 0.0f));
+				sphere->transform->SetScale(glm::vec3(0.5f));
 			}
 
 			std::shared_ptr<Actor> cube1 = game->CreateActor("Cube1");
@@ -42,7 +46,7 @@ namespace sparkle
 				auto mesh = Resource::LoadMesh("cube.obj");
 				std::shared_ptr<MeshRenderer> renderer = std::make_shared<MeshRenderer>(mesh, material, true);
 				cube1->AddComponent(renderer);
-				cube1->transform->position = glm::vec3(2.0f, 0.5, 1.0);
+				cube1->transform->SetPosition(glm::vec3(2.0f, 0.5, 1.0));
 			}
 
 			auto cube2 = game->CreateActor("Cube3");
@@ -75,13 +79,14 @@ namespace sparkle
 
 			std::shared_ptr<Actor> backpack = game->CreateActor("Backpack");
 			{
-				std::shared_ptr<Model> model = Resource::LoadModel("Assets/backpack/backpack.obj", material);
-				for(auto meshRenderer : model->m_meshRenderers)
-				{
-					backpack->AddComponent(meshRenderer);
-				}
-				backpack->transform->position = glm::vec3(0.0f, 0.0f, 0.0f);
-				backpack->transform->scale = glm::vec3(1.0f);
+				Resource::LoadModelAsync("Assets/backpack/backpack.obj", material, [backpack](std::shared_ptr<Model> model) {
+					for (auto meshRenderer : model->m_meshRenderers)
+					{
+						backpack->AddComponent(meshRenderer);
+					}
+				});
+				backpack->transform->SetPosition(glm::vec3(0.0f, 0.0f, 0.0f));
+				backpack->transform->SetScale(glm::vec3(1.0f));
 			}
 		}
 	};
@@ -102,22 +107,91 @@ namespace sparkle
 
 			std::shared_ptr<Actor> room = game->CreateActor("Room");
 			{
-				std::shared_ptr<Model> model = Resource::LoadModel("Assets\\Room\\room.obj", material, false);
-				for (auto meshRenderer : model->m_meshRenderers)
-				{
-					room->AddComponent(meshRenderer);
-				}
-
-				room->transform->position = glm::vec3(-5.0f, 0.0f, 15.0f);
-				room->transform->scale = glm::vec3(1.0f);
+				Resource::LoadModelAsync("Assets\\Room\\room.obj", material, [room](std::shared_ptr<Model> model) {
+					for (auto meshRenderer : model->m_meshRenderers)
+					{
+						room->AddComponent(meshRenderer);
+					}
+				}, false);
+
+				room->transform->SetPosition(glm::vec3(-5.0f, 0.0f, 15.0f));
+				room->transform->SetScale(glm::vec3(1.0f));
 			}
 		}
 	};
 }
 
-int main()
+int main(int argc, char* argv[])
 {
-	auto engine = std::make_unique<sparkle::SpEngine>();
+	sparkle::EngineOptions options;
+	for (int i = 1; i < argc; i++)
+	{
+		const std::string arg = argv[i];
+		if (arg == "--headless")
+		{
+			options.headless = true;
+		}
+		else if (arg == "--offscreen")
+		{
+			options.renderOffscreen = true;
+		}
+		else if (arg == "--frames" && i + 1 < argc)
+		{
+			options.maxFrames = std::atoi(argv[++i]);
+			options.benchmark.measuredFrames = options.maxFrames;
+		}
+		else if (arg == "--scene" && i + 1 < argc)
+		{
+			const std::string scene = argv[++i];
+			if (!scene.empty() && std::all_of(scene.begin(), scene.end(), ::isdigit))
+			{
+				options.sceneIndex = std::atoi(scene.c_str());
+			}
+			else
+			{
+				options.sceneName = scene;
+			}
+		}
+		else if (arg == "--record" && i + 1 < argc)
+		{
+			options.recordInputPath = argv[++i];
+		}
+		else if (arg == "--replay" && i + 1 < argc)
+		{
+			options.replayInputPath = argv[++i];
+		}
+		else if (arg == "--benchmark")
+		{
+			options.benchmark.enabled = true;
+		}
+		else if (arg == "--warmup" && i + 1 < argc)
+		{
+			options.benchmark.warmupFrames = std::atoi(argv[++i]);
+		}
+		else if (arg == "--report" && i + 1 < argc)
+		{
+			options.benchmark.reportPath = argv[++i];
+		}
+		else if (arg == "--baseline" && i + 1 < argc)
+		{
+			options.benchmark.baselinePath = argv[++i];
+		}
+		else if (arg == "--threshold" && i + 1 < argc)
+		{
+			options.benchmark.regressionThreshold = std::atof(argv[++i]);
+		}
+		else
+		{
+			fmt::print("Usage: sparkle [--headless [--offscreen]] [--frames N] [--scene INDEX|NAME] [--record FILE | --replay FILE]\n"
+				"               [--benchmark [--warmup N] [--report FILE] [--baseline FILE] [--threshold FRACTION]]\n"
+				"With --benchmark, --frames is the number of measured frames. Counting starts once the scene has loaded;\n"
+				"the first run cooks the scene's assets, so it takes longer to load.\n"
+				"--replay only replaces the game's input: the GUI still reads the live cursor, modifier keys and window focus.\n");
+			return -1;
+		}
+	}
+
+	auto engine = std::make_unique<sparkle::SpEngine>(options);
 
 	std::vector<std::shared_ptr<sparkle::Scene>> scenes = {
 		std::make_shared<sparkle::ScenePrimitiveRendering>(),
@@ -6,10 +6,37 @@
 #include <glm.hpp>
 
 #include <vector>
+#include <memory>
+
+#include "Bvh.h"
 
 namespace sparkle
 {
 
+// One level of detail: a range of the mesh's index buffer, over the vertices shared by all levels.
+struct MeshLod
+{
+	unsigned int firstIndex = 0;
+	unsigned int numIndices = 0;
+	// Largest deviation from the full-detail surface, in mesh space
+	float error = 0.0f;
+};
+
+// Non-owning view of vertex attributes and indices in the layout they are uploaded to the GPU,
+// e.g. pointing into a memory-mapped cooked mesh (see MeshCooker).
+struct MeshView
+{
+	const glm::vec3* positions = nullptr;
+	const glm::vec3* normals = nullptr;
+	const glm::vec2* texCoords = nullptr;
+	const unsigned int* indices = nullptr;
+	unsigned int numVertices = 0;
+	unsigned int numIndices = 0;
+	// Finest first; without any, all indices form a single level.
+	const MeshLod* lods = nullptr;
+	unsigned int numLods = 0;
+};
+
 class Mesh
 {
 public:
@@ -30,20 +57,23 @@ public:
 		}
 		unsigned int numVertices = static_cast<unsigned int>(packedVertices.size()) / stride;
 
+		std::vector<glm::vec3> positions;
+		std::vector<glm::vec3> normals;
+		std::vector<glm::vec2> texCoords;
 		for (unsigned int i = 0; i < numVertices; i++)
 		{
 			unsigned int baseV = stride * i;
 			unsigned int baseN = (stride >= 6) ? baseV + 3 : baseV;
 			unsigned int baseT = baseN + 3;
 
-			m_positions.push_back(glm::vec3(packedVertices[baseV + 0], packedVertices[baseV + 1], packedVertices[baseV + 2]));
+			positions.push_back(glm::vec3(packedVertices[baseV + 0], packedVertices[baseV + 1], packedVertices[baseV + 2]));
 			if (stride >= 6)
 			{
-				m_normals.push_back(glm::vec3(packedVertices[baseN + 0], packedVertices[baseN + 1], packedVertices[baseN + 2]));
+				normals.push_back(glm::vec3(packedVertices[baseN + 0], packedVertices[baseN + 1], packedVertices[baseN + 2]));
 			}
-			m_texCoords.push_back(glm::vec2(packedVertices[baseT + 0], packedVertices[baseT + 1]));
+			texCoords.push_back(glm::vec2(packedVertices[baseT + 0], packedVertices[baseT + 1]));
 		}
-		Initialize(m_positions, m_normals, m_texCoords, indices, attributeSizes);
+		Initialize(positions, normals, texCoords, indices, attributeSizes);
 	}
 
 	Mesh(const std::vector<glm::vec3>&& vertices,
@@ -54,22 +84,20 @@ public:
 		Initialize(vertices, normals, texCoords, indices, std::vector<unsigned int>());
 	}
 
+	/// <summary>
+	/// Construct the Mesh from a view of GPU-ready data, which is uploaded as-is without any per-element conversion.
+	/// </summary>
+	/// <param name="view"></param>
+	Mesh(const MeshView& view)
+	{
+		Initialize(view);
+	}
+
 	Mesh(const Mesh&) = delete;
 
 	~Mesh()
 	{
-		if (m_EBO > 0)
-		{
-			glDeleteBuffers(1, &m_EBO);
-		}
-		if (!m_VBOs.empty())
-		{
-			glDeleteBuffers((GLsizei)m_VBOs.size(), m_VBOs.data());
-		}
-		if (m_VAO > 0)
-		{
-			glDeleteVertexArrays(1, &m_VAO);
-		}
+		Release();
 	}
 
 	unsigned int VAO() const
@@ -90,18 +118,65 @@ public:
 	{
 		if (useIndices())
 		{
-			return static_cast<unsigned int>(m_indices.size());
+			return m_lods[0].numIndices;
 		}
 		else {
-			return static_cast<unsigned int>(m_positions.size());
+			return m_numVertices;
 		}
 	}
 
+	// Indices of all levels of detail
 	const std::vector<unsigned int>& indices() const
 	{
 		return m_indices;
 	}
 
+	unsigned int numLods() const
+	{
+		return static_cast<unsigned int>(m_lods.size());
+	}
+
+	const MeshLod& lod(unsigned int level) const
+	{
+		return m_lods[level];
+	}
+
+	// Bounding sphere in mesh space
+	glm::vec3 boundsCenter() const
+	{
+		return m_boundsCenter;
+	}
+
+	float boundsRadius() const
+	{
+		return m_boundsRadius;
+	}
+
+	/// <summary>
+	/// Hierarchy over the triangles of the finest level of detail, in mesh space, for picking and collision queries.
+	/// Built on first use by reading the positions back from the vertex buffer, so the first call must come from the
+	/// main thread, which owns the GL context; worker threads may query the tree once it exists.
+	/// Deformations through SetVerticesAndNormals() refit it.
+	/// </summary>
+	const Bvh& bvh()
+	{
+		if (!m_bvh)
+		{
+			// Meshes don't keep their vertices on the CPU, so only meshes that are queried pay for a copy
+			std::vector<glm::vec3> positions(m_numVertices);
+			if (m_numVertices > 0)
+			{
+				glBindBuffer(GL_ARRAY_BUFFER, verticesVBO());
+				glGetBufferSubData(GL_ARRAY_BUFFER, 0, m_numVertices * sizeof(glm::vec3), positions.data());
+				glBindBuffer(GL_ARRAY_BUFFER, 0);
+			}
+			const MeshLod& finest = m_lods[0];
+			m_bvh = std::make_unique<Bvh>(positions.data(), m_numVertices,
+				useIndices() ? m_indices.data() + finest.firstIndex : nullptr, finest.numIndices);
+		}
+		return *m_bvh;
+	}
+
 	const GLuint verticesVBO() const
 	{
 		return m_VBOs[0];
@@ -114,14 +189,32 @@ public:
 
 	void SetVerticesAndNormals(const std::vector<glm::vec3>& vertices, const std::vector<glm::vec3>& normals)
 	{
-		m_positions = vertices;
-		m_normals = normals;
+		if (m_bvh && vertices.size() != m_numVertices)
+		{
+			m_bvh.reset();
+		}
+		m_numVertices = static_cast<unsigned int>(vertices.size());
+		if (m_bvh)
+		{
+			m_bvh->Update(vertices.data());
+		}
 		glBindBuffer(GL_ARRAY_BUFFER, m_VBOs[0]);
 		glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(glm::vec3), vertices.data(), GL_DYNAMIC_DRAW);
 		glBindBuffer(GL_ARRAY_BUFFER, m_VBOs[1]);
 		glBufferData(GL_ARRAY_BUFFER, normals.size() * sizeof(glm::vec3), normals.data(), GL_DYNAMIC_DRAW);
 	}
 
+	/// <summary>
+	/// Replaces all mesh data and re-creates the GPU buffers.
+	/// Used to fill in placeholder meshes once their asynchronous load finishes.
+	/// </summary>
+	void SetData(const MeshView& view)
+	{
+		Release();
+		m_bvh.reset();
+		Initialize(view);
+	}
+
 	/// <summary>
 	/// Allocates a VBO and returns the handle.
 	/// </summary>
@@ -151,10 +244,13 @@ public:
 	}
 
 private:
-	std::vector<glm::vec3> m_positions;
-	std::vector<glm::vec3> m_normals;
-	std::vector<glm::vec2> m_texCoords;
+	// Vertex attributes only live in the GPU buffers; indices are kept for indices() and bvh()
+	unsigned int m_numVertices = 0;
 	std::vector<unsigned int> m_indices;
+	std::vector<MeshLod> m_lods;
+	glm::vec3 m_boundsCenter = glm::vec3(0.0f);
+	float m_boundsRadius = 0.0f;
+	std::unique_ptr<Bvh> m_bvh;
 
 	GLuint m_VAO = 0;
 	GLuint m_EBO = 0;
@@ -163,6 +259,25 @@ private:
 	// texCoords could result in m_VBOs[1] referring to one or the other, which could be confusing.
 	std::vector<GLuint> m_VBOs;
 
+	void Release()
+	{
+		if (m_EBO > 0)
+		{
+			glDeleteBuffers(1, &m_EBO);
+			m_EBO = 0;
+		}
+		if (!m_VBOs.empty())
+		{
+			glDeleteBuffers((GLsizei)m_VBOs.size(), m_VBOs.data());
+			m_VBOs.clear();
+		}
+		if (m_VAO > 0)
+		{
+			glDeleteVertexArrays(1, &m_VAO);
+			m_VAO = 0;
+		}
+	}
+
 	void Initialize(
 		const std::vector<glm::vec3>& vertices,
 		const std::vector<glm::vec3>& normals,
@@ -171,43 +286,101 @@ private:
 		const std::vector<unsigned int>& attributeSizes
 	)
 	{
-		m_positions = vertices;
-		m_normals = normals;
-		m_texCoords = texCoords;
-		m_indices = indices;
+		MeshView view;
+		view.positions = vertices.data();
+		view.normals = normals.empty() ? nullptr : normals.data();
+		view.texCoords = texCoords.empty() ? nullptr : texCoords.data();
+		view.indices = indices.empty() ? nullptr : indices.data();
+		view.numVertices = static_cast<unsigned int>(vertices.size());
+		view.numIndices = static_cast<unsigned int>(indices.size());
+		Initialize(view);
+	}
 
+	void Initialize(const MeshView& view)
+	{
+		// Vertex attributes go straight from the view to the GPU; only the indices are copied, for indices() and bvh().
+		m_numVertices = view.numVertices;
+		m_indices.clear();
+		if (view.indices)
+		{
+			m_indices.assign(view.indices, view.indices + view.numIndices);
+		}
+		SetLods(view);
+		ComputeBounds(view);
+		CreateBuffers(view);
+	}
+
+	void SetLods(const MeshView& view)
+	{
+		if (view.lods && view.numLods > 0)
+		{
+			m_lods.assign(view.lods, view.lods + view.numLods);
+		}
+		else
+		{
+			m_lods.assign(1, MeshLod{ 0, view.indices ? view.numIndices : 0, 0.0f });
+		}
+	}
+
+	// Centered on the bounding box; not minimal, but cheap and good enough for LOD selection.
+	void ComputeBounds(const MeshView& view)
+	{
+		m_boundsCenter = glm::vec3(0.0f);
+		m_boundsRadius = 0.0f;
+		if (view.numVertices == 0)
+		{
+			return;
+		}
+
+		glm::vec3 lower = view.positions[0];
+		glm::vec3 upper = view.positions[0];
+		for (unsigned int i = 1; i < view.numVertices; i++)
+		{
+			lower = glm::min(lower, view.positions[i]);
+			upper = glm::max(upper, view.positions[i]);
+		}
+		m_boundsCenter = (lower + upper) * 0.5f;
+		for (unsigned int i = 0; i < view.numVertices; i++)
+		{
+			m_boundsRadius = glm::max(m_boundsRadius, glm::length(view.positions[i] - m_boundsCenter));
+		}
+	}
+
+	// Uploads straight from the view, which may point into a memory-mapped file.
+	void CreateBuffers(const MeshView& view)
+	{
 		// Bind Vertex Array Object
 		glGenVertexArrays(1, &m_VAO);
 		glBindVertexArray(m_VAO);
 
 		// Copy our arrays into OpenGL buffers
-		if (!m_positions.empty())
+		if (view.numVertices > 0)
 		{
 			const GLuint vbo = AllocateVBO(3);
 			glBindBuffer(GL_ARRAY_BUFFER, vbo);
-			glBufferData(GL_ARRAY_BUFFER, m_positions.size() * sizeof(glm::vec3), m_positions.data(), GL_STATIC_DRAW);
+			glBufferData(GL_ARRAY_BUFFER, view.numVertices * sizeof(glm::vec3), view.positions, GL_STATIC_DRAW);
 		}
-		if (!m_normals.empty())
+		if (view.numVertices > 0 && view.normals)
 		{
 			const GLuint vbo = AllocateVBO(3);
 			glBindBuffer(GL_ARRAY_BUFFER, vbo);
-			glBufferData(GL_ARRAY_BUFFER, m_normals.size() * sizeof(glm::vec3), m_normals.data(), GL_STATIC_DRAW);
+			glBufferData(GL_ARRAY_BUFFER, view.numVertices * sizeof(glm::vec3), view.normals, GL_STATIC_DRAW);
 		}
-		if (!m_texCoords.empty())
+		if (view.numVertices > 0 && view.texCoords)
 		{
 			const GLuint vbo = AllocateVBO(2);
 			glBindBuffer(GL_ARRAY_BUFFER, vbo);
-			glBufferData(GL_ARRAY_BUFFER, m_texCoords.size() * sizeof(glm::vec2), m_texCoords.data(), GL_STATIC_DRAW);
+			glBufferData(GL_ARRAY_BUFFER, view.numVertices * sizeof(glm::vec2), view.texCoords, GL_STATIC_DRAW);
 		}
 		// Unbind to be safe
 		glBindBuffer(GL_ARRAY_BUFFER, 0);
 
 		// Copy our index array in an element buffer
-		if (useIndices())
+		if (view.numIndices > 0)
 		{
 			glGenBuffers(1, &m_EBO);
 			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
-			glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+			glBufferData(GL_ELEMENT_ARRAY_BUFFER, view.numIndices * sizeof(unsigned int), view.indices, GL_STATIC_DRAW);
 		}
 		// Unbind to be safe
 		glBindVertexArray(0);
@@ -28,5 +28,33 @@ namespace sparkle
 			result = rotationMatrix * glm::vec4(result, 0.0f);
 			return glm::normalize(result);
 		}
+
+		glm::quat EulerToQuat(const glm::vec3& degrees)
+		{
+			const glm::vec3 radians = glm::radians(degrees);
+			return glm::angleAxis(radians.y, glm::vec3(0, 1, 0)) *
+				glm::angleAxis(radians.z, glm::vec3(0, 0, 1)) *
+				glm::angleAxis(radians.x, glm::vec3(1, 0, 0));
+		}
+
+		glm::vec3 QuatToEuler(const glm::quat& rotation)
+		{
+			// Entries of Ry * Rz * Rx; m[column][row] as in glm
+			const glm::mat3 m = glm::mat3_cast(rotation);
+			const float sinZ = glm::clamp(m[0][1], -1.0f, 1.0f);
+			glm::vec3 result;
+			result.z = glm::asin(sinZ);
+			if (glm::abs(sinZ) < 0.999999f)
+			{
+				result.x = glm::atan(-m[2][1], m[1][1]);
+				result.y = glm::atan(-m[0][2], m[0][0]);
+			}
+			else
+			{
+				result.x = 0.0f;
+				result.y = glm::atan(m[2][0], m[2][2]);
+			}
+			return glm::degrees(result);
+		}
 	}
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include "fmt/format.h"
 #include "glm.hpp"
+#include "gtc/quaternion.hpp"
 
 template <>
 struct fmt::formatter<glm::vec3> : fmt::formatter<std::string> {
@@ -27,6 +28,12 @@ namespace sparkle
 
 		glm::vec3 RotateEuler(glm::vec3 result, const glm::vec3& rotation);
 
+		// Euler angles in degrees, applied in the same order as RotateEuler(): Y, then Z, then X.
+		glm::quat EulerToQuat(const glm::vec3& degrees);
+
+		// Inverse of EulerToQuat(), with the Z angle in [-90, 90]. At +-90 degrees around Z the X angle is 0.
+		glm::vec3 QuatToEuler(const glm::quat& rotation);
+
 		float Random(float min, float max);
 
 		template <class T>